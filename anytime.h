@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <iostream>
+
+// Wall-clock budget of a run (--time-limit SEC), counted from the start of
+// main. Solvers poll expired() and stop with the best path found so far; a
+// limit <= 0 never expires.
+class Deadline {
+public:
+    explicit Deadline(double seconds = 0) : start(std::chrono::steady_clock::now()), limit(seconds) {}
+
+    bool active() const {
+        return limit > 0;
+    }
+
+    bool expired() const {
+        return limit > 0 && elapsed() >= limit;
+    }
+
+    double elapsed() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+    double limit;
+};
+
+// Reads the --time-limit value: seconds >= 0, 0 for no limit. Prints an error
+// and returns false for anything else, so main() can stop with exit code 1.
+inline bool parse_time_limit(const std::string &text, double &seconds) {
+    try {
+        size_t used = 0;
+        seconds = std::stod(text, &used);
+        if (used == text.size() && seconds >= 0) {
+            return true;
+        }
+    } catch (const std::exception &) {
+    }
+    std::cerr << "invalid --time-limit '" << text << "' (expected seconds >= 0)\n";
+    return false;
+}
+
+// Timestamped stream of incumbent improvements on stderr, printed in anytime
+// runs only:
+//   incumbent 140 at 0.532 s
+// Safe to call from several threads: a value is printed only if it is below
+// everything reported before.
+class IncumbentLog {
+public:
+    explicit IncumbentLog(const Deadline &deadline) : deadline(deadline) {}
+
+    void improved(int value) {
+        if (!deadline.active()) {
+            return;
+        }
+        int cur = best.load(std::memory_order_relaxed);
+        do {
+            if (value >= cur) {
+                return;
+            }
+        } while (!best.compare_exchange_weak(cur, value, std::memory_order_relaxed));
+        std::fprintf(stderr, "incumbent %d at %.3f s\n", value, deadline.elapsed());
+    }
+
+private:
+    const Deadline &deadline;
+    std::atomic<int> best{INT_MAX};
+};
+
+enum class RunStatus {
+    Optimal,   // an exact search ran to completion
+    Finished,  // a heuristic ran to completion
+    TimeLimit, // stopped at the deadline, the printed path is the best found
+};
+
+// Last line on stderr of an anytime run.
+inline void report_status(const Deadline &deadline, RunStatus status) {
+    if (!deadline.active()) {
+        return;
+    }
+    const char *text = status == RunStatus::Optimal    ? "optimal"
+                       : status == RunStatus::Finished ? "finished (heuristic, not proven optimal)"
+                                                       : "time limit reached (not proven optimal)";
+    std::fprintf(stderr, "status: %s\n", text);
+}
@@ -0,0 +1,75 @@
+import json
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+# Checks exact_par --batch against one exact_par run per instance on random
+# small instances: symmetric and asymmetric matrices, s = 1 up to s = n, sizes
+# on both sides of the lockstep DP limit (12 vertices), so that both the DP and
+# the per-instance DFS of the batch are covered. Only the values are
+# compared, since equally good paths may differ.
+#
+#   python batch_check.py <exact_par> [instances] [seed]
+
+def instance(rng, name):
+    kind = rng.random()
+    if kind < 0.4:
+        # With one stop the DFS has no segments to bound, so these stay small
+        n, s = rng.randint(3, 9), 1
+    elif kind < 0.5:
+        # Over the lockstep DP limit: the DFS, kept fast by stopping everywhere
+        n = rng.randint(13, 14)
+        s = n
+    else:
+        n = rng.randint(3, 12)
+        s = rng.randint(2, n)
+    symmetric = rng.random() < 0.5
+    p = rng.choice([0.4, 0.7, 1.0])
+    graph = [[0] * n for _ in range(n)]
+    for i in range(n):
+        for j in range(n):
+            if i != j and (j > i or not symmetric) and rng.random() < p:
+                graph[i][j] = rng.randint(1, 100)
+                if symmetric:
+                    graph[j][i] = graph[i][j]
+    return {"name": name, "number of vertices": n, "number of stop vertices": s, "graph": graph,
+            "stop vertices": sorted(rng.sample(range(n), s))}
+
+def main():
+    if len(sys.argv) < 2:
+        print("Usage: python batch_check.py <exact_par> [instances] [seed]")
+        return 1
+    program = sys.argv[1]
+    count = int(sys.argv[2]) if len(sys.argv) > 2 else 200
+    rng = random.Random(int(sys.argv[3]) if len(sys.argv) > 3 else 1)
+
+    with tempfile.TemporaryDirectory() as folder:
+        instances = [instance(rng, f"t{i:04d}_{'sym' if i % 2 else 'asy'}") for i in range(count)]
+        batch_input = os.path.join(folder, "batch.jsonl")
+        batch_output = os.path.join(folder, "batch.txt")
+        with open(batch_input, "w") as f:
+            for data in instances:
+                f.write(json.dumps(data) + "\n")
+        subprocess.run([program, batch_input, "1", "--batch", "--output", batch_output], check=True,
+                       stderr=subprocess.DEVNULL)
+        with open(batch_output) as f:
+            batch = {line.split()[0]: line.split()[-1] for line in f}
+
+        differ = 0
+        for data in instances:
+            path = os.path.join(folder, data["name"] + ".json")
+            with open(path, "w") as f:
+                json.dump(data, f)
+            single = subprocess.run([program, path, "1"], capture_output=True, text=True).stdout.split()
+            single_value = single[-1] if single else "none"
+            if batch.get(data["name"]) != single_value:
+                differ += 1
+                print(f"{data['name']} (n {data['number of vertices']}, s {data['number of stop vertices']}): "
+                      f"batch {batch.get(data['name'])}, single {single_value}")
+        print(f"{count - differ} of {count} instances agree")
+        return 1 if differ else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Distributed exact search on one machine: a coordinator and several worker
+# processes on localhost. The result is checked against a single-process run.
+
+if [ "$#" -lt 2 ]; then
+    echo "Usage: $0 <exact_par_path> <test_case> [workers] [threads_per_worker] [port] [split_depth]"
+    exit 1
+fi
+
+PROGRAM="$1"
+TEST_CASE="$2"
+WORKERS="${3:-4}"
+THREADS="${4:-2}"
+PORT="${5:-5555}"
+SPLIT_DEPTH="${6:-3}"
+
+"$PROGRAM" "$TEST_CASE" 1 --coordinator "$PORT" --split-depth "$SPLIT_DEPTH" --stats > distributed_output.txt &
+COORDINATOR=$!
+for i in $(seq "$WORKERS"); do
+    "$PROGRAM" "$TEST_CASE" "$THREADS" --worker "localhost:$PORT" &
+done
+wait "$COORDINATOR"
+wait
+
+distributed=$(cat distributed_output.txt)
+single=$("$PROGRAM" "$TEST_CASE" "$THREADS" 2>/dev/null)
+rm -f distributed_output.txt
+echo "distributed:    $distributed"
+echo "single process: $single"
+if [ "${distributed##* }" != "${single##* }" ]; then
+    echo "values differ"
+    exit 1
+fi
@@ -0,0 +1,101 @@
+import sys
+from math import factorial
+
+# Combines the shard files of a brute_par run split with --range / --shard-output
+# and prints the result the way brute_par does. The shards have to belong to the
+# same instance, be complete and cover [0, n!) without gaps; otherwise the
+# missing or partial ranges are listed so that only they are run again.
+#
+#   python merge_shards.py plan <n> <shards>     BEGIN:END ranges for the shards
+#   python merge_shards.py <shard file>...       merged result
+
+# Returns None if the file is missing or malformed (a shard killed before its
+# first write leaves no file).
+def read_shard(path):
+    shard = {}
+    try:
+        with open(path) as f:
+            for line in f:
+                if line.strip():
+                    key, *values = line.split()
+                    shard[key] = values
+        return {
+            "file": path,
+            "instance": shard["instance"][0],
+            "n": int(shard["n"][0]),
+            "begin": int(shard["range"][0]),
+            "end": int(shard["range"][1]),
+            "complete": shard["status"][0] == "complete",
+            "value": int(shard["best"][0]),
+            "path": [int(v) for v in shard["best"][1:]],
+        }
+    except (OSError, KeyError, IndexError, ValueError):
+        return None
+
+def plan(n, count):
+    total = factorial(n)
+    bounds = [total * i // count for i in range(count + 1)]
+    for begin, end in zip(bounds, bounds[1:]):
+        if begin < end:
+            print(f"{begin}:{end}")
+
+def merge(paths):
+    shards, unreadable = [], []
+    for path in paths:
+        shard = read_shard(path)
+        if shard is None:
+            unreadable.append(path)
+        else:
+            shards.append(shard)
+    if unreadable:
+        print("Missing or unreadable shard files, run them again:", file=sys.stderr)
+        for path in unreadable:
+            print("  " + path, file=sys.stderr)
+    if not shards:
+        return 2
+    shards.sort(key=lambda s: (s["begin"], s["end"]))
+    if len({(s["instance"], s["n"]) for s in shards}) != 1:
+        print("Shards belong to different instances:", file=sys.stderr)
+        for s in shards:
+            print(f"  {s['file']}: instance {s['instance']}, n {s['n']}", file=sys.stderr)
+        return 1
+
+    total = factorial(shards[0]["n"])
+    missing = []
+    covered = 0
+    for s in shards:
+        # Ranges past n! are written as empty complete shards by brute_par
+        if s["begin"] >= s["end"]:
+            continue
+        if s["begin"] > covered:
+            missing.append(f"{covered}:{s['begin']} (no shard)")
+        if not s["complete"]:
+            missing.append(f"{s['begin']}:{s['end']} (partial in {s['file']})")
+        covered = max(covered, s["end"])
+    if covered < total:
+        missing.append(f"{covered}:{total} (no shard)")
+
+    found = [s for s in shards if s["value"] >= 0]
+    if found:
+        best = min(found, key=lambda s: s["value"])
+        print(" ".join(map(str, best["path"])), best["value"])
+    else:
+        print("No Hamiltonian path found that satisfies the conditions.")
+    if missing:
+        print("Incomplete, run these ranges again:", file=sys.stderr)
+        for r in missing:
+            print("  " + r, file=sys.stderr)
+    return 2 if missing or unreadable else 0
+
+def main():
+    if len(sys.argv) == 4 and sys.argv[1] == "plan":
+        plan(int(sys.argv[2]), int(sys.argv[3]))
+        return 0
+    if len(sys.argv) < 2:
+        print("Usage: python merge_shards.py plan <n> <shards>")
+        print("       python merge_shards.py <shard_file>...")
+        return 1
+    return merge(sys.argv[1:])
+
+if __name__ == "__main__":
+    sys.exit(main())
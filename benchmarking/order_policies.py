@@ -0,0 +1,58 @@
+import os
+import sys
+import csv
+import subprocess
+import time
+
+POLICIES = ["index", "cheapest", "nearest-stop", "warnsdorff"]
+
+def execute_test_case(program_args, test_case_path, policy, timeout=60*60):
+    """Run the exact solver with one child ordering policy; return time, value and node count."""
+    start_time = time.time()
+    try:
+        result = subprocess.run(
+            program_args[:1] + [test_case_path] + program_args[1:] + ["--order", policy, "--stats"],
+            capture_output=True,
+            text=True,
+            check=True,
+            timeout=timeout
+        )
+        execution_time = time.time() - start_time
+        nodes = "N/A"
+        for line in result.stderr.splitlines():
+            if line.startswith("search nodes"):
+                nodes = line.split()[-1]
+        value = result.stdout.strip().split()[-1]
+        return execution_time, value, nodes
+    except subprocess.TimeoutExpired:
+        return time.time() - start_time, "timeout", "N/A"
+    except subprocess.CalledProcessError as e:
+        return time.time() - start_time, f"Error: {e.stderr.strip()}", "N/A"
+
+def main():
+    if len(sys.argv) < 3:
+        print("Usage: python order_policies.py <program_path> <test_cases_folder> [program args...]")
+        print("e.g.   python order_policies.py exec/parallel/exact_par tests/raports 4")
+        sys.exit(1)
+
+    program_path = sys.argv[1]
+    test_cases_folder = sys.argv[2]
+    program_args = [program_path] + sys.argv[3:]
+
+    report_file = os.path.basename(program_path) + "_order_raport.csv"
+    with open(report_file, mode='w', newline='') as csvfile:
+        writer = csv.writer(csvfile)
+        writer.writerow(['test case', 'order', 'execution time', 'value', 'search nodes'])
+
+        test_cases = sorted(
+            test_case for test_case in os.listdir(test_cases_folder) if test_case.endswith('.json')
+        )
+        for test_case in test_cases:
+            test_case_path = os.path.join(test_cases_folder, test_case)
+            for policy in POLICIES:
+                execution_time, value, nodes = execute_test_case(program_args, test_case_path, policy)
+                print(test_case, policy, f"{execution_time:.4f}", value, nodes)
+                writer.writerow([test_case, policy, execution_time, value, nodes])
+
+if __name__ == "__main__":
+    main()
@@ -15,18 +15,23 @@ def parse_test_case_name(file_name):
     return n, p, s
 
 def execute_test_case(program_path, test_case_path, num_cores, timeout=60*60*2):
-    """Execute the program with the test case and return execution time and output."""
+    """Execute the program with the test case and return execution time and output.
+    Solvers stop themselves at --time-limit; their status line is appended to the output."""
     start_time = time.time()
     try:
         result = subprocess.run(
-            [program_path, test_case_path, str(num_cores)],
+            [program_path, test_case_path, str(num_cores), "--time-limit", str(timeout)],
             capture_output=True,
             text=True,
             check=True,
-            timeout=timeout
+            timeout=timeout + 60
         )
         execution_time = time.time() - start_time
-        return execution_time, result.stdout.strip()
+        output = result.stdout.strip()
+        for line in result.stderr.splitlines():
+            if line.startswith("status:"):
+                output += " (" + line[len("status:"):].strip() + ")"
+        return execution_time, output
     except subprocess.TimeoutExpired:
         execution_time = time.time() - start_time
         return execution_time, "Error: Execution timed out"
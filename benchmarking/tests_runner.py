@@ -11,7 +11,10 @@ timeout = 0.5
 def run_tests(program_path, test_case):
     try:
         start_time = time.time()
-        result = subprocess.run([program_path, test_case], encoding='utf-8', capture_output=True, check=True, timeout=timeout)
+        # Solvers with --time-limit stop at the timeout with their best path; the
+        # subprocess timeout only catches the ones that do not
+        result = subprocess.run([program_path, test_case, "--time-limit", str(timeout)], encoding='utf-8',
+                                capture_output=True, check=True, timeout=timeout + 5)
         end_time = time.time()
         lines = result.stdout.strip().split()
         solution_value = int(lines[-1])
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <climits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Adjacency matrix stored as one row of 64-bit words per vertex, so the exact
+// solvers can build the set of unvisited neighbours with a few word operations
+// and walk it with ctz instead of testing all n columns.
+struct BitsetGraph {
+    int n;
+    int words;
+    std::vector<uint64_t> rows;
+    std::vector<uint64_t> stop_bits;
+
+    // Edges heavier than max_weight are left out.
+    BitsetGraph(int n, int **graph, bool *stops = nullptr, int max_weight = INT_MAX)
+        : n(n), words((n + 63) / 64), rows(size_t(n) * words, 0), stop_bits(words, 0) {
+        for (int u = 0; u < n; ++u) {
+            for (int v = 0; v < n; ++v) {
+                if (graph[u][v] && graph[u][v] <= max_weight) {
+                    rows[size_t(u) * words + v / 64] |= uint64_t(1) << (v % 64);
+                }
+            }
+            if (stops && stops[u]) {
+                set(stop_bits.data(), u);
+            }
+        }
+    }
+
+    const uint64_t *row(int v) const {
+        return &rows[size_t(v) * words];
+    }
+
+    // out = neighbours(v) & ~visited
+    void candidates(int v, const uint64_t *visited, uint64_t *out) const {
+        const uint64_t *r = row(v);
+        if (words == 1) {
+            out[0] = r[0] & ~visited[0];
+            return;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        if (has_avx2()) {
+            andnot_avx2(r, visited, out, words);
+            return;
+        }
+#endif
+        for (int w = 0; w < words; ++w) {
+            out[w] = r[w] & ~visited[w];
+        }
+    }
+
+    // True if every unvisited vertex can be reached from v through unvisited
+    // vertices only; otherwise no Hamiltonian path extends the current prefix.
+    bool reaches_unvisited(int v, const uint64_t *visited) const {
+        if (words == 1) {
+            uint64_t remaining = ~visited[0] & (n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1);
+            uint64_t reached = 0, frontier = rows[v] & remaining;
+            while (frontier) {
+                reached |= frontier;
+                uint64_t next = 0;
+                for (; frontier; frontier &= frontier - 1) {
+                    next |= rows[__builtin_ctzll(frontier)];
+                }
+                frontier = next & remaining & ~reached;
+            }
+            return reached == remaining;
+        }
+        thread_local std::vector<uint64_t> reached, frontier, next;
+        reached.assign(words, 0);
+        frontier.resize(words);
+        next.resize(words);
+        candidates(v, visited, frontier.data());
+        bool growing = true;
+        while (growing) {
+            std::fill(next.begin(), next.end(), 0);
+            for (int w = 0; w < words; ++w) {
+                reached[w] |= frontier[w];
+                for (uint64_t f = frontier[w]; f; f &= f - 1) {
+                    const uint64_t *r = row(w * 64 + __builtin_ctzll(f));
+                    for (int k = 0; k < words; ++k) {
+                        next[k] |= r[k];
+                    }
+                }
+            }
+            growing = false;
+            for (int w = 0; w < words; ++w) {
+                frontier[w] = next[w] & ~visited[w] & ~reached[w];
+                growing |= frontier[w] != 0;
+            }
+        }
+        for (int w = 0; w < words; ++w) {
+            int bits_in_word = std::min(64, n - w * 64);
+            uint64_t all = bits_in_word == 64 ? ~uint64_t(0) : (uint64_t(1) << bits_in_word) - 1;
+            if ((reached[w] | visited[w]) != all) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // True if some unvisited stop has an index greater than v (needs the stops
+    // passed to the constructor). Used to keep only paths with first < last.
+    bool has_unvisited_stop_above(int v, const uint64_t *visited) const {
+        int w = v / 64;
+        uint64_t above = v % 64 == 63 ? 0 : ~uint64_t(0) << (v % 64 + 1);
+        if (stop_bits[w] & ~visited[w] & above) {
+            return true;
+        }
+        for (++w; w < words; ++w) {
+            if (stop_bits[w] & ~visited[w]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void set(uint64_t *bits, int v) {
+        bits[v / 64] |= uint64_t(1) << (v % 64);
+    }
+
+    static void reset(uint64_t *bits, int v) {
+        bits[v / 64] &= ~(uint64_t(1) << (v % 64));
+    }
+
+    static bool test(const uint64_t *bits, int v) {
+        return bits[v / 64] >> (v % 64) & 1;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    static bool has_avx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    __attribute__((target("avx2")))
+    static void andnot_avx2(const uint64_t *a, const uint64_t *b, uint64_t *out, int words) {
+        int w = 0;
+        for (; w + 4 <= words; w += 4) {
+            __m256i va = _mm256_loadu_si256((const __m256i *)(a + w));
+            __m256i vb = _mm256_loadu_si256((const __m256i *)(b + w));
+            _mm256_storeu_si256((__m256i *)(out + w), _mm256_andnot_si256(vb, va));
+        }
+        for (; w < words; ++w) {
+            out[w] = a[w] & ~b[w];
+        }
+    }
+#endif
+};
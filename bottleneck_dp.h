@@ -0,0 +1,211 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include <limits>
+#include <algorithm>
+
+// Largest instance the subset DP accepts: the table holds 2^n * n entries of 2
+// bytes (4 with large weights), about 800 MB (1.6 GB) at 24 vertices.
+const int BOTTLENECK_DP_MAX_VERTICES = 24;
+
+// Binary search over the bottleneck shared by the threshold engines.
+// feasible(B, path) returns true and a witness path whose segments are all <= B,
+// or false; value(path) is the real bottleneck of a witness. Every feasible probe
+// lowers the upper end to the witness value, so the search only moves between
+// segment sums that some path actually achieves. Returns INT_MAX if no path
+// exists even for upper_bound.
+template <typename Feasible, typename Value>
+int search_bottleneck(int n, int upper_bound, int *opt_path, Feasible feasible, Value value) {
+    std::vector<int> witness(n);
+    if (!feasible(upper_bound, witness.data())) {
+        return INT_MAX;
+    }
+    int hi = value(witness.data());
+    int lo = -1;
+    std::copy(witness.begin(), witness.end(), opt_path);
+    while (hi - lo > 1) {
+        int mid = lo + (hi - lo) / 2;
+        if (feasible(mid, witness.data())) {
+            hi = value(witness.data());
+            std::copy(witness.begin(), witness.end(), opt_path);
+        } else {
+            lo = mid;
+        }
+    }
+    return hi;
+}
+
+// No segment can be longer than the heaviest out-edge of every vertex summed.
+inline long long bottleneck_upper_bound(int n, int **graph) {
+    long long upper_bound = 0;
+    for (int u = 0; u < n; ++u) {
+        upper_bound += *std::max_element(graph[u], graph[u] + n);
+    }
+    return upper_bound;
+}
+
+// Held-Karp style exact engine for the "shortest longest segment" objective.
+//
+// For a fixed bottleneck B, table[mask][v] is the shortest open segment (weight
+// walked since the last stop) over all paths that visit exactly the vertices of
+// `mask`, end in v and keep every closed segment <= B. A Hamiltonian path with
+// bottleneck <= B exists iff some stop has a finite entry for the full mask.
+// solve() binary searches B with search_bottleneck().
+//
+// Requires s >= 2: the path has to end in a stop so every segment gets closed.
+template <typename T>
+class BottleneckDP {
+public:
+    static constexpr T INF = std::numeric_limits<T>::max();
+
+    BottleneckDP(int n, int **graph, bool *stops, bool start_at_stop)
+        : n(n), graph(graph), stops(stops), start_at_stop(start_at_stop),
+          in_adj(n, 0), table((size_t(1) << n) * n) {
+        for (int u = 0; u < n; ++u) {
+            for (int v = 0; v < n; ++v) {
+                if (graph[u][v]) {
+                    in_adj[v] |= 1u << u;
+                }
+            }
+        }
+    }
+
+    // Fills `path` with a witness and returns true if some Hamiltonian path keeps
+    // every segment <= bound.
+    bool feasible(int bound, int *path) {
+        for (int v = 0; v < n; ++v) {
+            table[(size_t(1) << v) * n + v] = (stops[v] || !start_at_stop) ? 0 : INF;
+        }
+        std::vector<uint32_t> layer;
+        for (int k = 2; k <= n; ++k) {
+            layer.clear();
+            for (uint32_t mask = (1u << k) - 1; mask < (1u << n);) {
+                layer.push_back(mask);
+                uint32_t c = mask & -mask, r = mask + c;
+                mask = (((r ^ mask) >> 2) / c) | r;
+            }
+            int reachable = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(| : reachable)
+#endif
+            for (size_t i = 0; i < layer.size(); ++i) {
+                reachable |= relax(layer[i], bound);
+            }
+            if (!reachable) {
+                return false;
+            }
+        }
+
+        uint32_t mask = (1u << n) - 1;
+        int last = -1;
+        for (int v = 0; v < n && last < 0; ++v) {
+            if (stops[v] && table[size_t(mask) * n + v] != INF) {
+                last = v;
+            }
+        }
+        if (last < 0) {
+            return false;
+        }
+        for (int pos = n - 1; pos > 0; --pos) {
+            path[pos] = last;
+            T target = table[size_t(mask) * n + last];
+            mask ^= 1u << last;
+            for (uint32_t us = mask & in_adj[last]; us; us &= us - 1) {
+                int u = __builtin_ctz(us);
+                T prev = table[size_t(mask) * n + u];
+                if (prev == INF) {
+                    continue;
+                }
+                // Compared as long long: T may be unsigned and the sum may exceed it
+                long long c = (long long)prev + graph[u][last];
+                if (stops[last] ? c <= bound : c == (long long)target) {
+                    last = u;
+                    break;
+                }
+            }
+        }
+        path[0] = last;
+        return true;
+    }
+
+    // Returns the optimal bottleneck and writes the path, or INT_MAX if none.
+    int solve(int *opt_path, int upper_bound) {
+        return search_bottleneck(
+            n, upper_bound, opt_path,
+            [this](int bound, int *path) { return feasible(bound, path); },
+            [this](const int *path) { return path_value(path); });
+    }
+
+private:
+    int n;
+    int **graph;
+    bool *stops;
+    bool start_at_stop;
+    std::vector<uint32_t> in_adj;
+    std::vector<T> table;
+
+    int relax(uint32_t mask, int bound) {
+        int reachable = 0;
+        T *row = &table[size_t(mask) * n];
+        for (uint32_t vs = mask; vs; vs &= vs - 1) {
+            int v = __builtin_ctz(vs);
+            uint32_t prev_mask = mask ^ (1u << v);
+            const T *prev_row = &table[size_t(prev_mask) * n];
+            T best = INF;
+            for (uint32_t us = prev_mask & in_adj[v]; us; us &= us - 1) {
+                int u = __builtin_ctz(us);
+                if (prev_row[u] == INF) {
+                    continue;
+                }
+                long long c = (long long)prev_row[u] + graph[u][v];
+                if (c > bound) {
+                    continue;
+                }
+                if (stops[v]) {
+                    best = 0;
+                    break;
+                }
+                if (c < (long long)best) {
+                    best = (T)c;
+                }
+            }
+            row[v] = best;
+            reachable |= best != INF;
+        }
+        return reachable;
+    }
+
+    int path_value(const int *path) {
+        int max_l = 0, cur_l = 0;
+        for (int i = 1; i < n; ++i) {
+            cur_l += graph[path[i - 1]][path[i]];
+            if (stops[path[i]]) {
+                max_l = std::max(max_l, cur_l);
+                cur_l = 0;
+            }
+        }
+        return max_l;
+    }
+};
+
+// Same contract as solve() in the DFS solvers: a new[]-allocated optimal path,
+// or nullptr when no Hamiltonian path satisfies the stop rules.
+inline int *solve_bottleneck_dp(int n, int **graph, bool *stops, bool start_at_stop) {
+    long long upper_bound = bottleneck_upper_bound(n, graph);
+    int *opt_path = new int[n];
+    int result;
+    if (upper_bound < std::numeric_limits<uint16_t>::max()) {
+        BottleneckDP<uint16_t> dp(n, graph, stops, start_at_stop);
+        result = dp.solve(opt_path, (int)upper_bound);
+    } else {
+        BottleneckDP<uint32_t> dp(n, graph, stops, start_at_stop);
+        result = dp.solve(opt_path, (int)std::min<long long>(upper_bound, INT_MAX - 1));
+    }
+    if (result == INT_MAX) {
+        delete[] opt_path;
+        return nullptr;
+    }
+    return opt_path;
+}
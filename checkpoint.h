@@ -0,0 +1,184 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstdint>
+#include <climits>
+#include <chrono>
+#include <atomic>
+
+// Unexplored subtree of the exact DFS: a path prefix and the state
+// (cur_l, max_l, used_s) after its last vertex.
+struct SubtreeRoot {
+    std::vector<int> prefix;
+    int cur_l, max_l, used_s;
+};
+
+// Saved exact search: the incumbent and the frontier of unexplored subtrees.
+// Exploring every frontier subtree under `bound` finishes the search, so an
+// interrupted run can be continued from the last checkpoint. The file is
+// little-endian binary:
+//   "HPCK" u32 version, u64 instance, i32 n, i32 bound, n x i32 path,
+//   u64 count, count x (i32 cur_l, i32 max_l, i32 used_s, u16 length, length x u16 vertex)
+struct Checkpoint {
+    static const uint32_t VERSION = 1;
+
+    uint64_t instance = 0; // instance_hash() of the search that wrote the file
+    int bound = INT_MAX;   // value of `path`, INT_MAX if there is no incumbent yet
+    std::vector<int> path;
+    std::vector<SubtreeRoot> frontier;
+
+    // Written to file + ".tmp" and renamed, so a job killed while saving keeps the
+    // previous checkpoint.
+    bool save(const std::string &file) const {
+        std::string tmp = file + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                return false;
+            }
+            out.write("HPCK", 4);
+            put<uint32_t>(out, VERSION);
+            put<uint64_t>(out, instance);
+            put<int32_t>(out, path.size());
+            put<int32_t>(out, bound);
+            for (int v : path) {
+                put<int32_t>(out, v);
+            }
+            put<uint64_t>(out, frontier.size());
+            for (const SubtreeRoot &root : frontier) {
+                put<int32_t>(out, root.cur_l);
+                put<int32_t>(out, root.max_l);
+                put<int32_t>(out, root.used_s);
+                put<uint16_t>(out, root.prefix.size());
+                for (int v : root.prefix) {
+                    put<uint16_t>(out, v);
+                }
+            }
+            if (!out.flush()) {
+                return false;
+            }
+        }
+        return std::rename(tmp.c_str(), file.c_str()) == 0;
+    }
+
+    bool load(const std::string &file) {
+        std::ifstream in(file, std::ios::binary);
+        char magic[4];
+        if (!in.read(magic, 4) || std::string(magic, 4) != "HPCK" || get<uint32_t>(in) != VERSION) {
+            return false;
+        }
+        instance = get<uint64_t>(in);
+        int32_t n = get<int32_t>(in);
+        if (!in || n < 0 || n > UINT16_MAX) {
+            return false;
+        }
+        path.resize(n);
+        bound = get<int32_t>(in);
+        for (int &v : path) {
+            v = get<int32_t>(in);
+        }
+        frontier.clear();
+        for (uint64_t count = get<uint64_t>(in); in && frontier.size() < count;) {
+            SubtreeRoot root;
+            root.cur_l = get<int32_t>(in);
+            root.max_l = get<int32_t>(in);
+            root.used_s = get<int32_t>(in);
+            root.prefix.resize(get<uint16_t>(in));
+            for (int &v : root.prefix) {
+                v = get<uint16_t>(in);
+            }
+            frontier.push_back(std::move(root));
+        }
+        return bool(in);
+    }
+
+    // True if the loaded search can be resumed on an instance with n vertices and
+    // s stops: the incumbent (if any) is a permutation of 0..n-1 and every
+    // frontier prefix is a non-empty list of distinct vertices below n with
+    // used_s in [0, s]. A damaged file can still carry the right instance hash.
+    bool fits(int n, int s) const {
+        if ((int)path.size() != n || (bound != INT_MAX && !distinct_vertices(path, n))) {
+            return false;
+        }
+        for (const SubtreeRoot &root : frontier) {
+            if (root.prefix.empty() || (int)root.prefix.size() > n || !distinct_vertices(root.prefix, n) ||
+                root.used_s < 0 || root.used_s > s || root.cur_l < 0 || root.max_l < 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    static bool distinct_vertices(const std::vector<int> &vertices, int n) {
+        std::vector<bool> seen(n, false);
+        for (int v : vertices) {
+            if (v < 0 || v >= n || seen[v]) {
+                return false;
+            }
+            seen[v] = true;
+        }
+        return true;
+    }
+
+    template <typename T>
+    static void put(std::ofstream &out, T value) {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static T get(std::ifstream &in) {
+        T value = 0;
+        in.read(reinterpret_cast<char *>(&value), sizeof(T));
+        return value;
+    }
+};
+
+// FNV-1a over the instance and the solver name, so a checkpoint is only resumed
+// by the search that wrote it.
+inline uint64_t instance_hash(int n, int s, int **graph, bool *stops, const std::string &solver) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash = (hash ^ (value >> (8 * i) & 0xff)) * 1099511628211ULL;
+        }
+    };
+    mix(n);
+    mix(s);
+    for (int u = 0; u < n; ++u) {
+        mix(stops[u]);
+        for (int v = 0; v < n; ++v) {
+            mix(graph[u][v]);
+        }
+    }
+    for (char c : solver) {
+        mix(c);
+    }
+    return hash;
+}
+
+// Deadline of the next periodic checkpoint, shared by all search threads. They
+// poll expired() every few thousand nodes, so the clock stays off the hot path.
+class CheckpointClock {
+public:
+    explicit CheckpointClock(int every_seconds) : interval(std::chrono::seconds(every_seconds)) {
+        restart();
+    }
+
+    bool expired() const {
+        return std::chrono::steady_clock::now().time_since_epoch().count() >=
+               deadline.load(std::memory_order_relaxed);
+    }
+
+    void restart() {
+        deadline.store((std::chrono::steady_clock::now() + interval).time_since_epoch().count(),
+                       std::memory_order_relaxed);
+    }
+
+private:
+    std::chrono::steady_clock::duration interval;
+    std::atomic<std::chrono::steady_clock::rep> deadline;
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <climits>
+#include <algorithm>
+#include "bitset_graph.h"
+
+// Order in which the exact DFS tries the children of a node.
+enum class OrderPolicy {
+    Index,       // ascending vertex number (the original loop)
+    Cheapest,    // lightest edge first
+    NearestStop, // smallest edge + shortest distance onward to a stop first
+    Warnsdorff   // fewest unvisited neighbours first, ties by edge weight
+};
+
+inline bool parse_order_policy(const std::string &name, OrderPolicy &policy) {
+    if (name == "index") {
+        policy = OrderPolicy::Index;
+    } else if (name == "cheapest") {
+        policy = OrderPolicy::Cheapest;
+    } else if (name == "nearest-stop") {
+        policy = OrderPolicy::NearestStop;
+    } else if (name == "warnsdorff") {
+        policy = OrderPolicy::Warnsdorff;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Per-vertex neighbour lists presorted for the static policies; Warnsdorff
+// sorts the candidates of each node by their remaining degree.
+class ChildOrder {
+public:
+    ChildOrder(int n, int **graph, bool *stops, OrderPolicy policy)
+        : n(n), graph(graph), policy(policy), neighbours(n) {
+        std::vector<int> key(n, 0);
+        if (policy == OrderPolicy::NearestStop) {
+            key = distances_to_stops(stops);
+        }
+        for (int u = 0; u < n; ++u) {
+            for (int v = 0; v < n; ++v) {
+                if (graph[u][v]) {
+                    neighbours[u].push_back(v);
+                }
+            }
+            if (policy == OrderPolicy::Cheapest || policy == OrderPolicy::NearestStop ||
+                policy == OrderPolicy::Warnsdorff) {
+                std::stable_sort(neighbours[u].begin(), neighbours[u].end(), [&](int a, int b) {
+                    return graph[u][a] + key[a] < graph[u][b] + key[b];
+                });
+            }
+        }
+    }
+
+    // Writes the vertices of the candidate set `cand` (children of u) to out in
+    // the policy's order and returns how many there are.
+    int order(int u, const uint64_t *cand, const uint64_t *visited, const BitsetGraph &bits, int *out) const {
+        int count = 0;
+        if (policy == OrderPolicy::Index) {
+            for (int w = 0; w < bits.words; ++w) {
+                for (uint64_t c = cand[w]; c; c &= c - 1) {
+                    out[count++] = w * 64 + __builtin_ctzll(c);
+                }
+            }
+            return count;
+        }
+        for (int v : neighbours[u]) {
+            if (BitsetGraph::test(cand, v)) {
+                out[count++] = v;
+            }
+        }
+        if (policy == OrderPolicy::Warnsdorff) {
+            thread_local std::vector<int> degree;
+            degree.resize(count);
+            for (int i = 0; i < count; ++i) {
+                degree[i] = remaining_degree(out[i], visited, bits);
+            }
+            // Insertion sort: stable, so equal degrees keep the cheapest-edge order
+            for (int i = 1; i < count; ++i) {
+                int v = out[i], d = degree[i], j = i - 1;
+                for (; j >= 0 && degree[j] > d; --j) {
+                    out[j + 1] = out[j];
+                    degree[j + 1] = degree[j];
+                }
+                out[j + 1] = v;
+                degree[j + 1] = d;
+            }
+        }
+        return count;
+    }
+
+private:
+    int n;
+    int **graph;
+    OrderPolicy policy;
+    std::vector<std::vector<int>> neighbours;
+
+    static int remaining_degree(int v, const uint64_t *visited, const BitsetGraph &bits) {
+        const uint64_t *r = bits.row(v);
+        int degree = 0;
+        for (int w = 0; w < bits.words; ++w) {
+            degree += __builtin_popcountll(r[w] & ~visited[w]);
+        }
+        return degree;
+    }
+
+    // Shortest distance from every vertex to the nearest stop (Dijkstra from all
+    // stops at once over reversed edges).
+    std::vector<int> distances_to_stops(bool *stops) const {
+        std::vector<int> dist(n, INT_MAX);
+        std::vector<bool> done(n, false);
+        for (int v = 0; v < n; ++v) {
+            if (stops[v]) {
+                dist[v] = 0;
+            }
+        }
+        for (int it = 0; it < n; ++it) {
+            int u = -1;
+            for (int v = 0; v < n; ++v) {
+                if (!done[v] && dist[v] != INT_MAX && (u < 0 || dist[v] < dist[u])) {
+                    u = v;
+                }
+            }
+            if (u < 0) {
+                break;
+            }
+            done[u] = true;
+            for (int v = 0; v < n; ++v) {
+                if (graph[v][u] && dist[u] + graph[v][u] < dist[v]) {
+                    dist[v] = dist[u] + graph[v][u];
+                }
+            }
+        }
+        for (int &d : dist) {
+            if (d == INT_MAX) {
+                d = 0;
+            }
+        }
+        return dist;
+    }
+};
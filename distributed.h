@@ -0,0 +1,198 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstring>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "checkpoint.h"
+
+// Line protocol of the distributed exact search (exact_par --coordinator /
+// --worker). Every message is one line of space-separated integers after a
+// keyword:
+//
+//   worker -> coordinator
+//     HELLO <instance hash>             first message, see instance_hash()
+//     GET                               the previous job is done, send the next
+//     IMPROVE <value> <path...>         a better path found by the worker
+//   coordinator -> worker
+//     BOUND <value> <path...>           the global incumbent, sent on every improvement
+//     JOB <cur_l> <max_l> <used_s> <k> <prefix...>   a subtree to search
+//     DONE                              no more jobs, the worker may exit
+//     BYE                               the worker solves another instance
+class Connection {
+public:
+    explicit Connection(int fd = -1) : fd(fd) {}
+
+    Connection(const Connection &) = delete;
+    Connection &operator=(const Connection &) = delete;
+
+    ~Connection() {
+        close();
+    }
+
+    bool open() const {
+        return fd >= 0;
+    }
+
+    int descriptor() const {
+        return fd;
+    }
+
+    void close() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    bool send_line(const std::string &line) {
+        std::string data = line + '\n';
+        for (size_t sent = 0; sent < data.size();) {
+            ssize_t count = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (count <= 0) {
+                return false;
+            }
+            sent += count;
+        }
+        return true;
+    }
+
+    // One recv() into the buffer; returns false once the peer has closed the
+    // connection (or it failed).
+    bool receive() {
+        char chunk[4096];
+        ssize_t count = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (count <= 0) {
+            return false;
+        }
+        buffer.append(chunk, count);
+        return true;
+    }
+
+    // Takes the next complete line out of the buffer, if there is one.
+    bool pop_line(std::string &line) {
+        size_t end = buffer.find('\n');
+        if (end == std::string::npos) {
+            return false;
+        }
+        line = buffer.substr(0, end);
+        buffer.erase(0, end + 1);
+        return true;
+    }
+
+    // Blocks until a whole line has arrived; false if the connection closed first.
+    bool read_line(std::string &line) {
+        while (!pop_line(line)) {
+            if (!receive()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    std::string buffer;
+};
+
+// Listening socket on all interfaces; -1 on failure.
+inline int listen_on(int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || ::listen(fd, 64) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Connected socket to "host:port"; -1 on failure.
+inline int connect_to(const std::string &address) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        return -1;
+    }
+    std::string host = address.substr(0, colon), port = address.substr(colon + 1);
+    addrinfo hints, *found = nullptr;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &found) != 0) {
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo *a = found; a && fd < 0; a = a->ai_next) {
+        fd = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd >= 0 && ::connect(fd, a->ai_addr, a->ai_addrlen) < 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    if (fd >= 0) {
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    }
+    return fd;
+}
+
+inline std::string format_path(const char *keyword, int value, const int *path, int n) {
+    std::ostringstream out;
+    out << keyword << ' ' << value;
+    for (int i = 0; i < n; ++i) {
+        out << ' ' << path[i];
+    }
+    return out.str();
+}
+
+inline std::string format_job(const SubtreeRoot &job) {
+    std::ostringstream out;
+    out << "JOB " << job.cur_l << ' ' << job.max_l << ' ' << job.used_s << ' ' << job.prefix.size();
+    for (int v : job.prefix) {
+        out << ' ' << v;
+    }
+    return out.str();
+}
+
+// Reads what follows the JOB keyword.
+inline bool parse_job(std::istringstream &in, int n, SubtreeRoot &job) {
+    size_t length;
+    if (!(in >> job.cur_l >> job.max_l >> job.used_s >> length) || length < 1 || length > (size_t)n) {
+        return false;
+    }
+    job.prefix.resize(length);
+    for (int &v : job.prefix) {
+        if (!(in >> v) || v < 0 || v >= n) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads what follows the BOUND and IMPROVE keywords.
+inline bool parse_path(std::istringstream &in, int n, int &value, std::vector<int> &path) {
+    path.resize(n);
+    if (!(in >> value)) {
+        return false;
+    }
+    for (int &v : path) {
+        if (!(in >> v) || v < 0 || v >= n) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <climits>
+#include "utils.h"
+#include "child_order.h"
+#include "transposition_table.h"
+
+// Optional pruning stages shared by the exact DFS solvers, set from the command line.
+struct ExactOptions {
+    // --connectivity-every K: at every K-th depth check that the unvisited vertices
+    // are still reachable from the end of the path (0 = off)
+    int connectivity_every = 0;
+    // Undirected instances: a path that starts and ends in a stop is only explored
+    // in the orientation with path[0] < path[n - 1]. Switched off with --no-symmetry
+    // and by the solvers themselves when the matrix is not symmetric or s < 2.
+    bool symmetry = true;
+    // --order index|cheapest|nearest-stop|warnsdorff: order of the children of a node
+    OrderPolicy order = OrderPolicy::Index;
+    // --warm-start-ms T: time budget of the greedy run whose path seeds the
+    // incumbent before the search starts (0 = start from INT_MAX)
+    int warm_start_ms = 100;
+    // --tt-mb M: size of the transposition table of (visited set, last vertex)
+    // states in MB (0 = no table)
+    int tt_mb = 0;
+    // --mitm-mb M: memory for the labels of the meet-in-the-middle engine in MB;
+    // the engine stops with an error instead of going beyond it
+    int mitm_mb = 4096;
+    // --checkpoint FILE: save the incumbent and the unexplored frontier to FILE
+    // every --checkpoint-every seconds (default 600) and when the search ends;
+    // --resume continues the search saved in FILE
+    std::string checkpoint;
+    int checkpoint_every = 600;
+    bool resume = false;
+    // --stats: also print the number of visited search nodes
+    bool stats = false;
+
+    static ExactOptions from_args(int argc, char **argv) {
+        ExactOptions opts;
+        if (!Utils::get_int_option(argc, argv, "connectivity-every", "0", 0, INT_MAX, opts.connectivity_every)) {
+            std::exit(1);
+        }
+        opts.symmetry = !Utils::has_option(argc, argv, "no-symmetry");
+        std::string order = Utils::get_option(argc, argv, "order", "index");
+        if (!parse_order_policy(order, opts.order)) {
+            std::cerr << "unknown order '" << order << "' (expected index, cheapest, nearest-stop or warnsdorff)\n";
+            std::exit(1);
+        }
+        if (!Utils::get_int_option(argc, argv, "warm-start-ms", "100", 0, INT_MAX, opts.warm_start_ms) ||
+            !Utils::get_int_option(argc, argv, "tt-mb", "0", 0, INT_MAX, opts.tt_mb) ||
+            !Utils::get_int_option(argc, argv, "mitm-mb", "4096", 1, INT_MAX, opts.mitm_mb)) {
+            std::exit(1);
+        }
+        opts.checkpoint = Utils::get_option(argc, argv, "checkpoint");
+        if (!Utils::get_int_option(argc, argv, "checkpoint-every", "600", 1, INT_MAX, opts.checkpoint_every)) {
+            std::exit(1);
+        }
+        opts.resume = Utils::has_option(argc, argv, "resume");
+        if (opts.resume && opts.checkpoint.empty()) {
+            std::cerr << "--resume needs --checkpoint FILE\n";
+            std::exit(1);
+        }
+        opts.stats = Utils::has_option(argc, argv, "stats");
+        return opts;
+    }
+};
+
+// Per-search counters, printed on stderr so the solution line stays unchanged.
+struct ExactStats {
+    int warm_start = INT_MAX;
+    long long nodes = 0;
+    long long connectivity_cuts = 0;
+    long long symmetry_cuts = 0;
+    TranspositionCounters tt;
+
+    void add(const ExactStats &other) {
+        nodes += other.nodes;
+        connectivity_cuts += other.connectivity_cuts;
+        symmetry_cuts += other.symmetry_cuts;
+        tt.add(other.tt);
+    }
+
+    void report(const ExactOptions &opts) const {
+        if (opts.stats) {
+            if (warm_start != INT_MAX) {
+                std::cerr << "warm start bound " << warm_start << "\n";
+            }
+            std::cerr << "search nodes " << nodes << "\n";
+        }
+        if (opts.connectivity_every > 0) {
+            std::cerr << "connectivity pruning cut " << connectivity_cuts << " nodes\n";
+        }
+        if (opts.symmetry) {
+            std::cerr << "symmetry breaking cut " << symmetry_cuts << " nodes\n";
+        }
+        if (opts.tt_mb > 0) {
+            std::cerr << "transposition table: " << tt.hits << " hits, " << tt.misses << " misses, "
+                      << tt.evictions << " evictions\n";
+        }
+    }
+};
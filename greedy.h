@@ -0,0 +1,372 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <queue>
+#include <functional>
+#include <numeric>
+#include <memory>
+#include "utils.h"
+#include "argmin_simd.h"
+
+struct PathWithMaxLength {
+    std::vector<int> path;
+    int max_length;
+};
+
+struct subpath {
+    vec_int path;
+    int weight;
+};
+
+// Row-remap view of the greedy's matrix. The greedy treats a subpath as a
+// single vertex whose outgoing edges are those of the subpath's end, so the
+// row of the first stop has to follow the end around. Instead of copying rows
+// into a private matrix, every run keeps its own logical row -> physical row
+// array over the shared read-only matrix: O(n) per run and no row copies.
+class GreedyRows {
+public:
+    explicit GreedyRows(const vec_vec_int &graph) : graph(graph), row_of(graph.size()) {
+        std::iota(row_of.begin(), row_of.end(), 0);
+    }
+
+    const vec_int &operator[](int v) const {
+        return graph[row_of[v]];
+    }
+
+    // Physical row behind v.
+    int row(int v) const {
+        return row_of[v];
+    }
+
+    // From now on v has the outgoing edges of w.
+    void follow(int v, int w) {
+        row_of[v] = row_of[w];
+    }
+
+private:
+    const vec_vec_int &graph;
+    vec_int row_of;
+};
+
+static const int GREEDY_SHARED_MIN_RUNS = 4;
+
+// The candidates of every row in the order the greedy prefers them, built once
+// per matrix and shared read-only by all greedy runs on it (every end vertex,
+// every thread): the non-stop neighbours ETAP I extends to, by (weight,
+// vertex), and the stop neighbours ETAP II merges with, by (weight, position in
+// all_stop_vertices). The greedy only ever removes candidates, so a run finds
+// the cheapest one left with a per-row cursor that never moves back, instead
+// of rescanning the row. Costs an n^2 log n sort up front, which pays off once
+// the greedy is run for GREEDY_SHARED_MIN_RUNS end vertices or more.
+class GreedyNeighbours {
+public:
+    GreedyNeighbours(const vec_vec_int &graph, const vec_int &all_stop_vertices)
+        : extend(graph.size()), merge(graph.size()) {
+        int n = graph.size();
+        vec_int position(n, -1);
+        for (int i = 0; i < (int)all_stop_vertices.size(); ++i) {
+            position[all_stop_vertices[i]] = i;
+        }
+#pragma omp parallel for schedule(dynamic, 16)
+        for (int u = 0; u < n; ++u) {
+            const vec_int &row = graph[u];
+            for (int v = 0; v < n; ++v) {
+                if (row[v]) {
+                    (position[v] < 0 ? extend[u] : merge[u]).push_back(v);
+                }
+            }
+            std::sort(extend[u].begin(), extend[u].end(),
+                      [&](int a, int b) { return row[a] != row[b] ? row[a] < row[b] : a < b; });
+            std::sort(merge[u].begin(), merge[u].end(),
+                      [&](int a, int b) { return row[a] != row[b] ? row[a] < row[b] : position[a] < position[b]; });
+        }
+    }
+
+    const vec_int &extensions(int row) const {
+        return extend[row];
+    }
+
+    const vec_int &merges(int row) const {
+        return merge[row];
+    }
+
+private:
+    vec_vec_int extend, merge;
+};
+
+// An extension or merge the greedy may take next. Both ETAPs take the cheapest
+// one, ties to the lower `from` (an index into stop_vertices) and then the lower
+// `to`, which is the order the original nested scans met them in. `version`
+// lets ETAP II recognise entries queued before `from` last changed.
+struct GreedyCandidate {
+    long long cost;
+    int from, to, version;
+    bool operator>(const GreedyCandidate &other) const {
+        if (cost != other.cost) {
+            return cost > other.cost;
+        }
+        return from != other.from ? from > other.from : to > other.to;
+    }
+};
+
+typedef std::priority_queue<GreedyCandidate, std::vector<GreedyCandidate>, std::greater<GreedyCandidate>> GreedyHeap;
+
+// ETAP I: extends the subpaths of stop_vertices (each holding its stop) one
+// vertex at a time, `steps` times, always by the cheapest extension over all of
+// them: subpath weight plus the edge from its end to a vertex with to_use set,
+// ties to the earlier stop and then the lower vertex. Every stop keeps its
+// cheapest extension in a heap; taking a vertex only invalidates the entries
+// that point at it, and those are rescanned when they reach the top, so a step
+// costs a row scan or two instead of a scan of all s rows (or a few cursor
+// steps with `neighbours`). The row scans are the vector masked argmin of
+// argmin_simd.h, split across threads for long rows. The row of a stop follows
+// the end of its subpath.
+// Returns false if no extension is left.
+inline bool greedy_grow_subpaths(int n, GreedyRows &graph, const vec_int &stop_vertices,
+                                 std::vector<subpath> &subpaths, vec_bool &to_use, int steps,
+                                 const GreedyNeighbours *neighbours = nullptr) {
+    GreedyHeap heap;
+    vec_int cursor(neighbours ? n : 0, 0);
+    // to_use as -1/0 words for the vector scans
+    vec_int available(n);
+    for (int i = 0; i < n; ++i) {
+        available[i] = to_use[i] ? -1 : 0;
+    }
+    // Pushes the cheapest extension of stop_vertices[order], if it has one
+    auto push_cheapest = [&](int order) {
+        int v = stop_vertices[order];
+        const vec_int &row = graph[v];
+        int best = -1;
+        if (neighbours) {
+            const vec_int &candidates = neighbours->extensions(graph.row(v));
+            int &c = cursor[graph.row(v)];
+            while (c < (int)candidates.size() && !to_use[candidates[c]]) {
+                ++c;
+            }
+            best = c < (int)candidates.size() ? candidates[c] : -1;
+        } else {
+            best = masked_argmin_parallel(row.data(), available.data(), n);
+        }
+        if (best >= 0) {
+            heap.push({(long long)subpaths[v].weight + row[best], order, best, 0});
+        }
+    };
+    for (int order = 0; order < (int)stop_vertices.size(); ++order) {
+        push_cheapest(order);
+    }
+    for (int j = 0; j < steps; ++j) {
+        GreedyCandidate top;
+        do {
+            if (heap.empty()) {
+                return false;
+            }
+            top = heap.top();
+            heap.pop();
+            if (!to_use[top.to]) {
+                push_cheapest(top.from);
+            }
+        } while (!to_use[top.to]);
+        int v_from = stop_vertices[top.from], v_to = top.to;
+        subpaths[v_from].path.push_back(v_to);
+        subpaths[v_from].weight += graph[v_from][v_to];
+        graph.follow(v_from, v_to);
+        to_use[v_to] = 0;
+        available[v_to] = 0;
+        push_cheapest(top.from);
+    }
+    return true;
+}
+
+// ETAP II: merges the subpaths of stop_vertices (heads with to_use clear) into
+// one, s - 2 times for s - 1 subpaths: subpath u takes subpath v at the cost of
+// u's weight plus the edge from u's end to v, the segment closed by the merge
+// counts towards max_path_len and u continues with v's open weight and end row.
+// Only the first s - 2 stops can take another subpath. Every head keeps its
+// cheapest merge in a heap; entries go stale when their head changes (version)
+// or when their target is taken, and are dropped or rescanned when they reach
+// the top. Merges only link segments (next segment and last segment of every
+// head), and the chain is written out once at the end into `joined`. With
+// `neighbours`, heads find their cheapest merge with per-row cursors as in ETAP I.
+inline bool greedy_join_subpaths(GreedyRows &graph, const vec_int &stop_vertices, const std::vector<subpath> &subpaths,
+                                 vec_bool &to_use, subpath &joined, int &max_path_len,
+                                 const GreedyNeighbours *neighbours = nullptr) {
+    int count = stop_vertices.size();
+    vec_int weight(count), version(count, 0), next_segment(count, -1), last_segment(count);
+    for (int i = 0; i < count; ++i) {
+        weight[i] = subpaths[stop_vertices[i]].weight;
+        last_segment[i] = i;
+    }
+    vec_int cursor, order_of;
+    if (neighbours) {
+        cursor.assign(subpaths.size(), 0);
+        order_of.assign(subpaths.size(), -1);
+        for (int j = 0; j < count; ++j) {
+            order_of[stop_vertices[j]] = j;
+        }
+    }
+    GreedyHeap heap;
+    // Pushes the cheapest merge of head i, if it has one
+    auto push_cheapest = [&](int i) {
+        const vec_int &row = graph[stop_vertices[i]];
+        int best = -1;
+        if (neighbours) {
+            // Skipping the head itself for good is safe: the row only passes to
+            // another head when this one is taken
+            const vec_int &candidates = neighbours->merges(graph.row(stop_vertices[i]));
+            int &c = cursor[graph.row(stop_vertices[i])];
+            while (c < (int)candidates.size() && (to_use[candidates[c]] || candidates[c] == stop_vertices[i])) {
+                ++c;
+            }
+            best = c < (int)candidates.size() ? order_of[candidates[c]] : -1;
+        } else {
+            for (int j = 0; j < count; ++j) {
+                int v = stop_vertices[j];
+                if (j != i && !to_use[v] && row[v] && (best < 0 || row[v] < row[stop_vertices[best]])) {
+                    best = j;
+                }
+            }
+        }
+        if (best >= 0) {
+            heap.push({(long long)weight[i] + row[stop_vertices[best]], i, best, version[i]});
+        }
+    };
+    for (int i = 0; i < count - 1; ++i) {
+        push_cheapest(i);
+    }
+    for (int k = 0; k < count - 1; ++k) {
+        GreedyCandidate top;
+        bool valid = false;
+        while (!valid) {
+            if (heap.empty()) {
+                return false;
+            }
+            top = heap.top();
+            heap.pop();
+            if (to_use[stop_vertices[top.from]] || top.version != version[top.from]) {
+                continue;
+            }
+            valid = !to_use[stop_vertices[top.to]];
+            if (!valid) {
+                push_cheapest(top.from);
+            }
+        }
+        int u = stop_vertices[top.from], v = stop_vertices[top.to];
+        max_path_len = std::max(max_path_len, weight[top.from] + graph[u][v]);
+        weight[top.from] = weight[top.to];
+        graph.follow(u, v);
+        to_use[v] = 1;
+        next_segment[last_segment[top.from]] = top.to;
+        last_segment[top.from] = last_segment[top.to];
+        ++version[top.from];
+        push_cheapest(top.from);
+    }
+    for (int i = 0; i < count; ++i) {
+        if (!to_use[stop_vertices[i]]) {
+            joined = {{}, weight[i]};
+            for (int segment = i; segment >= 0; segment = next_segment[segment]) {
+                const vec_int &part = subpaths[stop_vertices[segment]].path;
+                joined.path.insert(joined.path.end(), part.begin(), part.end());
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// One pass of the greedy heuristic with all_stop_vertices[end_vertex] as the last
+// vertex. ETAP I grows a subpath from every other stop, always taking the cheapest
+// extension; ETAP II chains the subpaths together. `graph_original` is only
+// read (see GreedyRows); runs over many end vertices can share `neighbours`
+// built from the same matrix and stops. Returns false if the construction gets
+// stuck.
+inline bool greedy_construct(int n, int s, const vec_vec_int &graph_original, const vec_int &all_stop_vertices,
+                             int end_vertex, PathWithMaxLength &result,
+                             const GreedyNeighbours *neighbours = nullptr) {
+    GreedyRows graph(graph_original);
+    std::vector<subpath> subpaths(n);
+    vec_bool to_use(n, 1);
+    for (int i = 0; i < s; ++i) {
+        to_use[all_stop_vertices[i]] = 0;
+        if (i != end_vertex) {
+            subpaths[all_stop_vertices[i]].path.push_back(all_stop_vertices[i]);
+            subpaths[all_stop_vertices[i]].weight = 0;
+        }
+    }
+    vec_int stop_vertices = all_stop_vertices;
+    stop_vertices.erase(stop_vertices.begin() + end_vertex);
+    // ETAP I
+    if (!greedy_grow_subpaths(n, graph, stop_vertices, subpaths, to_use, n - s, neighbours)) {
+        return false;
+    }
+    // ETAP II
+    to_use[all_stop_vertices[end_vertex]] = 1;
+    int max_path_len = 0;
+    subpath path;
+    if (!greedy_join_subpaths(graph, stop_vertices, subpaths, to_use, path, max_path_len, neighbours)) {
+        return false;
+    }
+    if (graph[path.path[path.path.size() - 1]][all_stop_vertices[end_vertex]]) {
+        if (path.weight + graph[path.path[path.path.size() - 1]][all_stop_vertices[end_vertex]] > max_path_len) {
+            max_path_len = path.weight + graph[path.path[path.path.size() - 1]][all_stop_vertices[end_vertex]];
+        }
+    } else {
+        return false;
+    }
+    path.path.push_back(all_stop_vertices[end_vertex]);
+    result = {path.path, max_path_len};
+    return true;
+}
+
+// Initial incumbent for the exact solvers: the greedy path for every choice of the
+// last stop, until budget_ms runs out. The
+// greedy result is only a candidate, so it is checked against the exact solvers'
+// rules (Hamiltonian, starts and ends in a stop) and rescored the way they score
+// paths. Returns the best value with its path, or INT_MAX if nothing qualified.
+inline int greedy_warm_start(int n, int s, int **graph, bool *stops, int budget_ms, int *best_path) {
+    if (budget_ms <= 0 || s < 2) {
+        return INT_MAX;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget_ms);
+    vec_vec_int original(n, vec_int(n));
+    vec_int stop_vertices;
+    for (int u = 0; u < n; ++u) {
+        std::copy(graph[u], graph[u] + n, original[u].begin());
+        if (stops[u]) {
+            stop_vertices.push_back(u);
+        }
+    }
+    std::unique_ptr<GreedyNeighbours> neighbours;
+    if (s >= GREEDY_SHARED_MIN_RUNS) {
+        neighbours.reset(new GreedyNeighbours(original, stop_vertices));
+    }
+    int best = INT_MAX;
+    for (int end_vertex = 0; end_vertex < s && std::chrono::steady_clock::now() < deadline; ++end_vertex) {
+        PathWithMaxLength result;
+        if (!greedy_construct(n, s, original, stop_vertices, end_vertex, result, neighbours.get()) || (int)result.path.size() != n ||
+            !stops[result.path[0]]) {
+            continue;
+        }
+        vec_bool seen(n, 0);
+        int max_l = 0, cur_l = 0;
+        bool valid = true;
+        seen[result.path[0]] = 1;
+        for (int i = 1; i < n && valid; ++i) {
+            int u = result.path[i - 1], v = result.path[i];
+            valid = !seen[v] && graph[u][v];
+            seen[v] = 1;
+            cur_l += graph[u][v];
+            if (stops[v]) {
+                max_l = std::max(max_l, cur_l);
+                cur_l = 0;
+            }
+        }
+        if (valid && stops[result.path[n - 1]] && max_l < best) {
+            best = max_l;
+            std::copy(result.path.begin(), result.path.end(), best_path);
+        }
+    }
+    return best;
+}
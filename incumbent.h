@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <climits>
+#include <vector>
+
+// Best solution shared by all search threads without a mutex.
+//
+// The bound is a std::atomic<int>: the pruning path reads it with relaxed loads
+// and improvements lower it with a CAS-min, so a new bound is visible to every
+// thread as soon as it is found. The path behind the bound is published through
+// a seqlock: readers retry instead of waiting, and writers (rare - only on an
+// improvement) take turns by moving the sequence number to an odd value.
+class Incumbent {
+public:
+    explicit Incumbent(int n) : n(n), path(n) {}
+
+    int bound() const {
+        return value.load(std::memory_order_relaxed);
+    }
+
+    // Returns true if max_l became the new bound; the path is then published.
+    bool offer(int max_l, const int *candidate) {
+        int cur = value.load(std::memory_order_relaxed);
+        do {
+            if (max_l >= cur) {
+                return false;
+            }
+        } while (!value.compare_exchange_weak(cur, max_l, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        unsigned s = seq.load(std::memory_order_relaxed);
+        do {
+            while (s & 1) {
+                s = seq.load(std::memory_order_relaxed);
+            }
+        } while (!seq.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed));
+        std::atomic_thread_fence(std::memory_order_release);
+        // A better path may have been published while we were waiting for our turn
+        if (max_l < published.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < n; ++i) {
+                path[i].store(candidate[i], std::memory_order_relaxed);
+            }
+            published.store(max_l, std::memory_order_relaxed);
+        }
+        seq.store(s + 2, std::memory_order_release);
+        return true;
+    }
+
+    // Consistent copy of the published path; returns its value (INT_MAX if none).
+    int snapshot(int *out) const {
+        while (true) {
+            unsigned s1 = seq.load(std::memory_order_acquire);
+            if (s1 & 1) {
+                continue;
+            }
+            int result = published.load(std::memory_order_relaxed);
+            for (int i = 0; i < n; ++i) {
+                out[i] = path[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s1) {
+                return result;
+            }
+        }
+    }
+
+private:
+    int n;
+    std::atomic<int> value{INT_MAX};
+    std::atomic<int> published{INT_MAX};
+    std::atomic<unsigned> seq{0};
+    std::vector<std::atomic<int>> path;
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+
+// One instance of a lockstep batch, in the arrays the solvers read.
+struct LaneInstance {
+    int n;
+    int **graph;
+    bool *stops;
+};
+
+// The feasibility DP of bottleneck_dp.h run for up to LANES instances of the
+// same size at once, one instance per lane: table[mask][v][lane] is the
+// shortest open segment over paths of that lane's instance that visit `mask`,
+// end in v and keep every closed segment <= the lane's bound. Every lane binary
+// searches its own bottleneck, but all lanes run exactly the same loops over
+// masks and vertices, so the work per (mask, v, u) is one fixed-length loop over
+// the lanes that the compiler turns into vector instructions. Missing edges are
+// weight 0 lanes, which keeps the control flow identical for every instance.
+//
+// Meant for batches of tiny instances, where a process, a JSON parse and a DFS
+// per instance cost more than the search itself. Follows the stop rules of the
+// dp engine: the path ends in a stop, with start_at_stop it also starts in one,
+// and every instance needs s >= 2.
+class LockstepDP {
+public:
+    static constexpr int LANES = 16;
+    static constexpr int MAX_VERTICES = 12;
+
+    LockstepDP(int n, bool start_at_stop)
+        : n(n), start_at_stop(start_at_stop), weights(n * n), stop(n), table((size_t(1) << n) * n) {}
+
+    // Solves batch[0..count), count <= LANES, every instance with this n.
+    // values[i] is the optimal bottleneck of batch[i] with its path in paths[i],
+    // or INT_MAX if no path satisfies the stop rules.
+    void solve(const LaneInstance *batch, int count, int *values, std::vector<int> *paths) {
+        Lanes lo, hi, bound;
+        for (int l = 0; l < LANES; ++l) {
+            // Spare lanes repeat the first instance and are never read back
+            const LaneInstance &instance = batch[l < count ? l : 0];
+            int upper_bound = 0;
+            for (int u = 0; u < n; ++u) {
+                upper_bound += *std::max_element(instance.graph[u], instance.graph[u] + n);
+                stop[u][l] = instance.stops[u] ? -1 : 0;
+                for (int v = 0; v < n; ++v) {
+                    weights[u * n + v][l] = instance.graph[u][v];
+                }
+            }
+            lo[l] = -1;
+            hi[l] = bound[l] = std::min(upper_bound, INF - 1);
+        }
+
+        // As in search_bottleneck(): every feasible probe lowers hi to the value of
+        // the witness, so the lanes only move between values some path achieves
+        std::vector<int> witness(n);
+        bool probing = true;
+        for (int round = 0; probing; ++round) {
+            feasible(bound);
+            probing = false;
+            for (int l = 0; l < count; ++l) {
+                if (round > 0 && (hi[l] == INT_MAX || hi[l] - lo[l] <= 1)) {
+                    continue;
+                }
+                if (backtrack(l, bound[l], witness.data())) {
+                    hi[l] = path_value(l, witness.data());
+                    paths[l] = witness;
+                } else if (round == 0) {
+                    hi[l] = INT_MAX;
+                    continue;
+                } else {
+                    lo[l] = bound[l];
+                }
+                probing |= hi[l] - lo[l] > 1;
+            }
+            for (int l = 0; l < LANES; ++l) {
+                bound[l] = l < count && hi[l] != INT_MAX && hi[l] - lo[l] > 1 ? lo[l] + (hi[l] - lo[l]) / 2 : 0;
+            }
+        }
+        for (int l = 0; l < count; ++l) {
+            values[l] = hi[l];
+        }
+    }
+
+private:
+    using Lanes = std::array<int32_t, LANES>;
+    static constexpr int32_t INF = INT32_MAX / 2;
+
+    int n;
+    bool start_at_stop;
+    std::vector<Lanes> weights; // weights[u * n + v]
+    std::vector<Lanes> stop;    // -1 for a stop, 0 otherwise
+    std::vector<Lanes> table;
+
+    // The lane loops only vectorise well with the min/blend instructions of AVX2
+    // and later, so feasible() is compiled for each ISA and picked at run time
+    __attribute__((target_clones("avx512f", "avx2", "default"))) void feasible(const Lanes &bound) {
+        for (int v = 0; v < n; ++v) {
+            Lanes &start = table[(size_t(1) << v) * n + v];
+            for (int l = 0; l < LANES; ++l) {
+                start[l] = (stop[v][l] || !start_at_stop) ? 0 : INF;
+            }
+        }
+        // A mask only depends on masks with one bit less, which are smaller numbers
+        for (uint32_t mask = 3; mask < (1u << n); ++mask) {
+            if (!(mask & (mask - 1))) {
+                continue;
+            }
+            for (uint32_t vs = mask; vs; vs &= vs - 1) {
+                int v = __builtin_ctz(vs);
+                uint32_t prev_mask = mask ^ (1u << v);
+                Lanes best;
+                best.fill(INF);
+                const Lanes &stop_v = stop[v];
+                for (uint32_t us = prev_mask; us; us &= us - 1) {
+                    int u = __builtin_ctz(us);
+                    const Lanes &prev = table[size_t(prev_mask) * n + u];
+                    const Lanes &w = weights[u * n + v];
+                    for (int l = 0; l < LANES; ++l) {
+                        int32_t c = prev[l] + w[l];
+                        bool ok = w[l] != 0 && prev[l] < INF && c <= bound[l];
+                        int32_t candidate = ok ? (stop_v[l] ? 0 : c) : INF;
+                        best[l] = std::min(best[l], candidate);
+                    }
+                }
+                table[size_t(mask) * n + v] = best;
+            }
+        }
+    }
+
+    // The witness of one lane after feasible(), as in BottleneckDP::feasible().
+    bool backtrack(int l, int bound, int *path) {
+        uint32_t mask = (1u << n) - 1;
+        int last = -1;
+        for (int v = 0; v < n && last < 0; ++v) {
+            if (stop[v][l] && table[size_t(mask) * n + v][l] < INF) {
+                last = v;
+            }
+        }
+        if (last < 0) {
+            return false;
+        }
+        for (int pos = n - 1; pos > 0; --pos) {
+            path[pos] = last;
+            int32_t target = table[size_t(mask) * n + last][l];
+            mask ^= 1u << last;
+            for (uint32_t us = mask; us; us &= us - 1) {
+                int u = __builtin_ctz(us);
+                int32_t prev = table[size_t(mask) * n + u][l], w = weights[u * n + last][l];
+                if (prev >= INF || w == 0) {
+                    continue;
+                }
+                int32_t c = prev + w;
+                if (stop[last][l] ? c <= bound : c == target) {
+                    last = u;
+                    break;
+                }
+            }
+        }
+        path[0] = last;
+        return true;
+    }
+
+    int path_value(int l, const int *path) const {
+        int max_l = 0, cur_l = 0;
+        for (int i = 1; i < n; ++i) {
+            cur_l += weights[path[i - 1] * n + path[i]][l];
+            if (stop[path[i]][l]) {
+                max_l = std::max(max_l, cur_l);
+                cur_l = 0;
+            }
+        }
+        return max_l;
+    }
+};
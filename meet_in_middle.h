@@ -0,0 +1,313 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include <atomic>
+#include <algorithm>
+#include "bottleneck_dp.h"
+#include "exact_options.h"
+#include "greedy.h"
+
+// Meet-in-the-middle exact engine. The objective restarts at every stop, so a
+// half path only matters through its label: the longest closed segment (max_l)
+// and the weight of the segment still open at the junction (open). A path
+// path[0..n-1] is cut at the junction J = path[m], m = (n - 1) / 2:
+//   forward halves path[0..m] are grown from the allowed starts,
+//   backward halves path[m..n-1] are grown from the stops towards the start,
+// layer by layer, keeping only the Pareto front of labels for every (visited
+// set, junction) key. A forward and a backward half fit together iff their
+// sets share only J and cover all vertices, and the joined value is
+//   max(max_l_f, max_l_b, open_f + open_b).
+// Every layer holds at most C(n, k) * k keys instead of the n! / (n - k)! half
+// paths the DFS walks through, and labels >= upper_bound are dropped.
+//
+// Layers are sorted arrays of (key, max_l, open), 16 bytes per label: sorting
+// groups the labels of a key and Pareto filtering is one pass over each group.
+// Every thread filters its extensions in place as they grow, so a layer is
+// never held unfiltered; the labels held at once are capped by --mitm-mb, and
+// a search that would need more stops with exceeded() set instead of running
+// the machine out of memory.
+// Follows the stop rules of check_all_possible_paths: the path ends in a stop,
+// and with start_at_stop it also starts in one. Needs s >= 2.
+class MeetInMiddle {
+public:
+    // (visited set, vertex) keys are packed into 64 bits as in transposition_table.h.
+    // This only bounds the key format: how far the engine gets below it depends
+    // on the graph and on --mitm-mb (a complete graph needs about 1.6 GB at n = 22).
+    static const int MAX_VERTICES = 58;
+
+    MeetInMiddle(int n, int s, int **graph, bool *stops, bool start_at_stop, const ExactOptions &opts)
+        : n(n), s(s), graph(graph), stops(stops), start_at_stop(start_at_stop), opts(opts), out_adj(n, 0),
+          in_adj(n, 0), budget((long long)opts.mitm_mb << 20) {
+        for (int u = 0; u < n; ++u) {
+            for (int v = 0; v < n; ++v) {
+                if (graph[u][v]) {
+                    out_adj[u] |= uint64_t(1) << v;
+                    in_adj[v] |= uint64_t(1) << u;
+                }
+            }
+            if (stops[u]) {
+                stop_mask |= uint64_t(1) << u;
+            }
+        }
+        all = (uint64_t(1) << n) - 1;
+    }
+
+    static bool supports(int n) {
+        return n <= MAX_VERTICES;
+    }
+
+    // Returns the optimal value and writes its path, or INT_MAX if no path
+    // satisfies the stop rules or the layers outgrew --mitm-mb (see exceeded()).
+    // The greedy warm start (--warm-start-ms) gives the first upper bound.
+    int solve(int *opt_path) {
+        int warm_start = greedy_warm_start(n, s, graph, stops, opts.warm_start_ms, opt_path);
+        int upper_bound = warm_start;
+        if (upper_bound == INT_MAX) {
+            upper_bound = (int)std::min<long long>(bottleneck_upper_bound(n, graph) + 1, INT_MAX);
+        }
+        int found = search(upper_bound, opt_path);
+        if (over_budget) {
+            return INT_MAX;
+        }
+        return found == INT_MAX ? warm_start : found;
+    }
+
+    // True if the search stopped because its labels would need more than --mitm-mb.
+    bool exceeded() const {
+        return over_budget;
+    }
+
+private:
+    struct Label {
+        uint64_t key; // visited set << 6 | junction
+        int max_l;
+        int open;
+    };
+
+    int n, s;
+    int **graph;
+    bool *stops;
+    bool start_at_stop;
+    const ExactOptions &opts;
+    std::vector<uint64_t> out_adj, in_adj;
+    uint64_t stop_mask = 0, all;
+    // Bytes of label storage allowed, and held at the moment (vector capacities)
+    long long budget;
+    std::atomic<long long> held{0};
+    std::atomic<bool> over_budget{false};
+
+    // Returns the best value below upper_bound and writes its path, or INT_MAX
+    // if no path beats upper_bound.
+    int search(int upper_bound, int *opt_path) {
+        int m = (n - 1) / 2;
+        std::vector<Label> forward, backward;
+        for (int v = 0; v < n; ++v) {
+            if (stops[v] || !start_at_stop) {
+                forward.push_back({key(uint64_t(1) << v, v), 0, 0});
+            }
+            if (stops[v]) {
+                backward.push_back({key(uint64_t(1) << v, v), 0, 0});
+            }
+        }
+        held = bytes(forward) + bytes(backward);
+        for (int size = 1; size < m + 1 && !over_budget; ++size) {
+            expand(forward, true, upper_bound);
+        }
+        for (int size = 1; size < n - m && !over_budget; ++size) {
+            expand(backward, false, upper_bound);
+        }
+        if (over_budget) {
+            return INT_MAX;
+        }
+
+        // Join: every backward half looks up the forward halves ending in the same
+        // junction and covering the remaining vertices
+        std::atomic<int> best(upper_bound);
+        Label best_f{0, 0, 0}, best_b{0, 0, 0};
+#pragma omp parallel for schedule(dynamic, 1024)
+        for (size_t i = 0; i < backward.size(); ++i) {
+            const Label &b = backward[i];
+            int junction = b.key & 63;
+            uint64_t wanted = key((all ^ (b.key >> 6)) | uint64_t(1) << junction, junction);
+            auto group = std::lower_bound(forward.begin(), forward.end(), Label{wanted, 0, 0}, by_key);
+            for (; group != forward.end() && group->key == wanted; ++group) {
+                // The group is sorted by max_l, so no later label can do better
+                if (group->max_l >= best.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                int value = std::max(std::max(group->max_l, b.max_l), group->open + b.open);
+                if (value < best.load(std::memory_order_relaxed)) {
+#pragma omp critical(meet_in_middle_best)
+                    if (value < best.load()) {
+                        best.store(value);
+                        best_f = *group;
+                        best_b = b;
+                    }
+                }
+            }
+        }
+        if (best.load() >= upper_bound) {
+            return INT_MAX;
+        }
+
+        // Labels do not keep their paths: each half is found again by a DFS
+        // restricted to its own vertex set
+        std::vector<int> half(n);
+        find_half(best_f, true, m + 1, half.data());
+        std::copy(half.begin(), half.begin() + m + 1, opt_path);
+        find_half(best_b, false, n - m, half.data());
+        for (int i = 0; i < n - m; ++i) {
+            opt_path[n - 1 - i] = half[i];
+        }
+        return best.load();
+    }
+
+    static uint64_t key(uint64_t mask, int v) {
+        return mask << 6 | v;
+    }
+
+    static bool by_key(const Label &a, const Label &b) {
+        return a.key < b.key;
+    }
+
+    static long long bytes(const std::vector<Label> &labels) {
+        return (long long)labels.capacity() * sizeof(Label);
+    }
+
+    // Records a change of held label storage; false once it is over the budget.
+    bool account(long long delta) {
+        if (held.fetch_add(delta, std::memory_order_relaxed) + delta > budget) {
+            over_budget.store(true, std::memory_order_relaxed);
+        }
+        return !over_budget.load(std::memory_order_relaxed);
+    }
+
+    // Replaces layer by the next one. Forward halves append v after their last
+    // vertex u; backward halves prepend u before their first vertex v, so their
+    // open segment is the one running from the new vertex to the first stop.
+    // A thread's extensions are filtered whenever they have doubled since the
+    // last filtering, and the filtered parts are merged and filtered once more.
+    void expand(std::vector<Label> &layer, bool forward, int upper_bound) {
+        std::vector<Label> next;
+#pragma omp parallel
+        {
+            std::vector<Label> local;
+            size_t filter_at = MIN_FILTER;
+#pragma omp for schedule(dynamic, 256) nowait
+            for (size_t i = 0; i < layer.size(); ++i) {
+                if (over_budget.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                const Label &l = layer[i];
+                uint64_t mask = l.key >> 6;
+                int end = l.key & 63;
+                for (uint64_t ws = (forward ? out_adj[end] : in_adj[end]) & ~mask; ws; ws &= ws - 1) {
+                    int w = __builtin_ctzll(ws);
+                    uint64_t next_mask = mask | uint64_t(1) << w;
+                    // The last stop has to be path[n - 1], which is never in a forward half
+                    if (forward && stops[w] && __builtin_popcountll(next_mask & stop_mask) == s) {
+                        continue;
+                    }
+                    int segment = l.open + (forward ? graph[end][w] : graph[w][end]);
+                    if (segment >= upper_bound) {
+                        continue;
+                    }
+                    Label extended{key(next_mask, w), l.max_l, segment};
+                    if (stops[w]) {
+                        extended.max_l = std::max(l.max_l, segment);
+                        extended.open = 0;
+                    }
+                    long long before = bytes(local);
+                    local.push_back(extended);
+                    if (bytes(local) != before && !account(bytes(local) - before)) {
+                        break;
+                    }
+                }
+                if (local.size() >= filter_at) {
+                    pareto_filter(local);
+                    filter_at = std::max(MIN_FILTER, 2 * local.size());
+                }
+            }
+            pareto_filter(local);
+#pragma omp critical(meet_in_middle_layer)
+            {
+                long long before = bytes(next) + bytes(local);
+                if (next.empty()) {
+                    next.swap(local);
+                } else if (!over_budget.load(std::memory_order_relaxed)) {
+                    next.insert(next.end(), local.begin(), local.end());
+                }
+                std::vector<Label>().swap(local);
+                account(bytes(next) - before);
+            }
+        }
+        pareto_filter(next);
+        account(-bytes(layer));
+        layer.swap(next);
+    }
+
+    // Thread-local extensions below this many labels are not filtered yet
+    static constexpr size_t MIN_FILTER = 1 << 16;
+
+    // Keeps, for every key, the labels not dominated by another label of the
+    // key (max_l and open both <=). Sorts and compacts in place.
+    static void pareto_filter(std::vector<Label> &labels) {
+        std::sort(labels.begin(), labels.end(), [](const Label &a, const Label &b) {
+            if (a.key != b.key) {
+                return a.key < b.key;
+            }
+            return a.max_l != b.max_l ? a.max_l < b.max_l : a.open < b.open;
+        });
+        size_t kept = 0;
+        for (size_t i = 0; i < labels.size(); ++i) {
+            if (kept == 0 || labels[i].key != labels[kept - 1].key || labels[i].open < labels[kept - 1].open) {
+                labels[kept++] = labels[i];
+            }
+        }
+        labels.resize(kept);
+    }
+
+    // Writes a half path with the vertex set of `target`, ending (forward) or
+    // starting (backward) in its junction, whose label is no worse than
+    // target's. Backward halves are written from path[n - 1] towards the junction.
+    void find_half(const Label &target, bool forward, int size, int *half) {
+        uint64_t mask = target.key >> 6;
+        for (uint64_t vs = mask; vs; vs &= vs - 1) {
+            int v = __builtin_ctzll(vs);
+            if (forward ? (stops[v] || !start_at_stop) : stops[v]) {
+                half[0] = v;
+                if (extend_half(target, forward, size, 1, uint64_t(1) << v, 0, 0, half)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    bool extend_half(const Label &target, bool forward, int size, int pos, uint64_t visited, int max_l, int open,
+                     int *half) {
+        int junction = target.key & 63;
+        int end = half[pos - 1];
+        if (pos == size) {
+            return end == junction && max_l <= target.max_l && open <= target.open;
+        }
+        for (uint64_t ws = (forward ? out_adj[end] : in_adj[end]) & (target.key >> 6) & ~visited; ws; ws &= ws - 1) {
+            int w = __builtin_ctzll(ws);
+            if ((w == junction) != (pos == size - 1)) {
+                continue;
+            }
+            int segment = open + (forward ? graph[end][w] : graph[w][end]);
+            int next_max_l = stops[w] ? std::max(max_l, segment) : max_l;
+            int next_open = stops[w] ? 0 : segment;
+            if (next_max_l > target.max_l) {
+                continue;
+            }
+            half[pos] = w;
+            if (extend_half(target, forward, size, pos + 1, visited | uint64_t(1) << w, next_max_l, next_open, half)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
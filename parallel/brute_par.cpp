@@ -18,8 +18,14 @@ Uruchomienie:
 #include <vector>
 #include <cassert>
 #include <omp.h>
+#include <atomic>
+#include <fstream>
+#include <cstdio>
 
 #include "../utils.h"
+#include "../anytime.h"
+#include "../permutation_walk.h"
+#include "../checkpoint.h"
 
 // Helper function to calculate factorials (can overflow for n > 20)
 // check if only half the permutations can be generated
@@ -36,111 +42,119 @@ std::vector<uint64_t> calculate_factorials(unsigned int n) {
     return facts;
 }
 
-// Function to generate the k-th lexicographical permutation of 0..n-1
-// Uses precomputed factorials
-// Writes the result into the provided result_perm array/vector data
-void get_kth_permutation(unsigned int n, uint64_t k, const std::vector<uint64_t>& factorials, int* result_perm) {
-    std::vector<int> available_elements(n);
-    std::iota(available_elements.begin(), available_elements.end(), 0);
-
-    uint64_t remainder = k;
-
-    for (unsigned int i = 0; i < n; ++i) {
-        unsigned int factorial_idx = n - 1 - i;
-        uint64_t factorial_val = (factorial_idx < factorials.size()) ? factorials[factorial_idx] : 1;
-        if (factorial_val == 0) factorial_val = 1; // Avoid division by zero for 0!
-
-        uint64_t index_in_available = remainder / factorial_val;
-        remainder = remainder % factorial_val;
-
-        if (index_in_available >= available_elements.size()) {
-            // Should not happen if k < n!
-            // Handle defensively - place last element? Or throw?
-             // This might indicate k was too large or calculation error.
-             // For robustness maybe: index_in_available = available_elements.size() - 1;
-             // Or better: throw std::runtime_error("Permutation index calculation error.");
-             index_in_available = available_elements.size() -1; // Simple clamp for now
-        }
+// Hands out ranges of chunk_size permutation ranks from a shared cursor, as
+// schedule(dynamic, chunk_size) did, so that once the deadline passes the
+// remaining ranges are dropped instead of visited one by one. A thread that
+// proves a whole prefix block dead beyond the end of its range moves the cursor
+// past that block, so the next ranges start at live ranks instead of being
+// handed out only to be skipped.
+class RankScheduler {
+public:
+    RankScheduler(uint64_t begin, uint64_t end, uint64_t chunk_size)
+        : count(end), chunk_size(chunk_size), cursor(begin) {}
+
+    bool claim(uint64_t &first, uint64_t &last) {
+        first = cursor.fetch_add(chunk_size);
+        last = std::min(count, first + chunk_size);
+        return first < count;
+    }
 
-        result_perm[i] = available_elements[index_in_available];
-        available_elements.erase(available_elements.begin() + index_in_available);
+    // Every rank below `rank` is searched or dead; never moves the cursor back.
+    void skip_to(uint64_t rank) {
+        uint64_t cur = cursor.load();
+        while (cur < rank && !cursor.compare_exchange_weak(cur, rank)) {
+        }
     }
-}
 
-bool is_hamiltonian(int n, int **graph, const int *permutation)
+private:
+    uint64_t count, chunk_size;
+    std::atomic<uint64_t> cursor;
+};
+
+// --range BEGIN:END limits the search to the permutation ranks [BEGIN, END), so a
+// large enumeration can be split over processes or hosts; --shard-output FILE
+// keeps what the shard found. END is clipped to n!.
+struct Shard {
+    uint64_t begin = 0, end = UINT64_MAX;
+    std::string output;
+};
+
+// Shard result file, one "key values..." line each, combined by
+// benchmarking/merge_shards.py:
+//   instance <hash>            instance_hash() of the matrix, the stops and "brute_par"
+//   n <n>
+//   range <begin> <end>
+//   status complete|partial    partial: stopped by --time-limit
+//   best <value> <path...>     "best -1" if no permutation of the range is a path
+// Written to FILE.tmp and renamed, like checkpoints, so a shard killed midway
+// leaves no file and is simply run again.
+bool write_shard(const std::string &file, uint64_t instance, int n, const Shard &shard, bool complete, int value,
+                 const std::vector<int> &path)
 {
-    for (int j = 0; j < n - 1; j++)
+    std::string tmp = file + ".tmp";
     {
-        if (graph[permutation[j]][permutation[j + 1]] == 0)
-        {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << "instance " << instance << "\nn " << n << "\nrange " << shard.begin << ' ' << shard.end
+            << "\nstatus " << (complete ? "complete" : "partial") << "\nbest ";
+        if (path.empty()) {
+            out << -1;
+        } else {
+            out << value;
+            for (int v : path) {
+                out << ' ' << v;
+            }
+        }
+        out << '\n';
+        if (!out.flush()) {
             return false;
         }
     }
-    // if (graph[permutation[n - 1]][permutation[0]] == 0) return false;
-
-    return true;
+    return std::rename(tmp.c_str(), file.c_str()) == 0;
 }
 
-int max_subpath(int n, const int *path, int **graph, const bool *stops)
+// Rerunning a shard whose complete result is already on disk (same instance and
+// range) only reports that result, so a failed batch of shards can be restarted
+// as a whole.
+bool read_complete_shard(const std::string &file, uint64_t instance, int n, const Shard &shard, int &value,
+                         std::vector<int> &path)
 {
-    int current_subpath_sum = 0;
-    int max_found = 0; // Initialize max found subpath sum
-
-    for (int i = 0; i < n - 1; ++i)
-    {
-        // If the current node is a designated stop
-        if (stops[path[i]])
-        {
-            // Check if the completed subpath is the longest so far
-            if (current_subpath_sum > max_found) {
-                max_found = current_subpath_sum;
+    std::ifstream in(file);
+    std::string key, status;
+    uint64_t saved_instance, begin, end;
+    int saved_n;
+    if (!(in >> key >> saved_instance >> key >> saved_n >> key >> begin >> end >> key >> status >> key >> value) ||
+        saved_instance != instance || saved_n != n || begin != shard.begin || end != shard.end ||
+        status != "complete") {
+        return false;
+    }
+    path.clear();
+    if (value >= 0) {
+        path.resize(n);
+        for (int &v : path) {
+            if (!(in >> v)) {
+                return false;
             }
-            // Reset sum for the next subpath starting after this stop
-            current_subpath_sum = 0;
-        }
-
-        // Add the weight of the edge from path[i] to path[i+1]
-        // Check if edge exists? is_hamiltonian should guarantee this, but belt-and-suspenders?
-        int edge_weight = graph[path[i]][path[i + 1]];
-        if (edge_weight == 0) {
-            // This path isn't actually valid according to the graph weights provided
-            // Handle error: return a special value (e.g., -1) or throw?
-            // Let's assume is_hamiltonian already validated this.
-            // std::cerr << "Warning: Edge weight 0 found in supposedly Hamiltonian path.\n";
         }
-        current_subpath_sum += edge_weight;
     }
-
-    // After the loop, check the last subpath (from the last stop to the end)
-    if (current_subpath_sum > max_found) {
-        max_found = current_subpath_sum;
-    }
-
-    // If the path had no stops at all, max_found might still be 0 if all weights are 0.
-    // If the path has stops, but all segments sum to 0 or less, max_found will be 0.
-    // If no edges were traversed (n=1), max_found is 0.
-    // Consider edge cases based on problem definition if stops[path[0]] should reset sum immediately.
-    // The current logic calculates sums *between* stops (and start/end).
-
-    return max_found;
+    return true;
 }
 
-
 // --- Refactored Main Function ---
 
-void find_min_max_path(Utils utils, int n, int **graph, bool *stops)
+// On a symmetric matrix a permutation and its reverse have the same value, so
+// only the orientation with perm[0] < perm[n - 1] is evaluated. A prefix that
+// misses an edge or already has a segment at the best value found by any thread
+// skips its whole block of (n - 1 - i)! ranks.
+// Only the ranks of `shard` are searched, and its result file is written if
+// one was given. Stops at the deadline with the best permutation checked so far.
+void find_min_max_path(Utils utils, int n, int **graph, bool *stops, bool symmetric, const Deadline &deadline,
+                       Shard shard)
 {
     if (n <= 1) {
         std::cout << "Path requires at least 2 vertices.\n";
         return;
     }
 
-    if (!utils.is_connected_arrays(n, graph))
-    {
-        std::cout << "Graph is not connected. No Hamiltonian path possible.\n";
-        return;
-    }
-
     std::vector<uint64_t> factorials;
     uint64_t permutation_count = 0;
     try {
@@ -153,11 +167,48 @@ void find_min_max_path(Utils utils, int n, int **graph, bool *stops)
         std::cerr << "Error during precomputation: " << e.what() << std::endl;
         return;
     }
-    std::cout << "Total permutations to check: " << permutation_count << std::endl;
+    uint64_t requested_end = shard.end;
+    shard.end = std::max(shard.begin, std::min(shard.end, permutation_count));
+    uint64_t instance = instance_hash(n, 0, graph, stops, "brute_par");
+    // Nothing to search is still a finished shard, so that the merge sees it
+    auto write_empty_shard = [&]() {
+        if (!shard.output.empty() && !write_shard(shard.output, instance, n, shard, true, 0, std::vector<int>())) {
+            std::cerr << "Unable to write shard result to '" << shard.output << "'.\n";
+        }
+    };
 
+    if (!utils.is_connected_arrays(n, graph))
+    {
+        std::cout << "Graph is not connected. No Hamiltonian path possible.\n";
+        write_empty_shard();
+        return;
+    }
+    if (shard.begin == shard.end) {
+        std::cerr << "Empty range " << shard.begin << ":" << requested_end << " (n! = " << permutation_count << ")\n";
+        write_empty_shard();
+        return;
+    }
+    std::cout << "Total permutations to check: " << shard.end - shard.begin << std::endl;
 
     std::vector<int> global_best_path;
     int global_min_max = std::numeric_limits<int>::max();
+    if (!shard.output.empty() &&
+        read_complete_shard(shard.output, instance, n, shard, global_min_max, global_best_path)) {
+        std::cerr << "shard " << shard.begin << ":" << shard.end << " already complete in '" << shard.output << "'\n";
+        if (global_best_path.empty()) {
+            std::cout << "No Hamiltonian path found that satisfies the conditions.\n";
+        } else {
+            for (int node : global_best_path) {
+                std::cout << node << ' ';
+            }
+            std::cout << global_min_max << '\n';
+        }
+        return;
+    }
+    RankScheduler scheduler(shard.begin, shard.end, 10000);
+    std::atomic<int> shared_best(std::numeric_limits<int>::max());
+    std::atomic<bool> time_up(false);
+    IncumbentLog log(deadline);
 
     #pragma omp parallel
     {
@@ -165,30 +216,66 @@ void find_min_max_path(Utils utils, int n, int **graph, bool *stops)
         int local_min_max = std::numeric_limits<int>::max();
         bool thread_found_path = false;
 
-        std::vector<int> current_perm_buffer(n);
-        const int chunk_size = 10000;
-
-        #pragma omp for schedule(dynamic, chunk_size) nowait // nowait: threads proceed to critical section when done
-        for (uint64_t k = 0; k < permutation_count; ++k) {
-
-            // 1. Generate k-th permutation into thread-local buffer
-            get_kth_permutation(n, k, factorials, current_perm_buffer.data());
-
-            // 2. Check if it's a Hamiltonian path
-            if (is_hamiltonian(n, graph, current_perm_buffer.data())) {
-
-                // 3. Calculate the max subpath length for this valid path
-                int current_max_subpath = max_subpath(n, current_perm_buffer.data(), graph, stops);
+        PermutationWalk walk(n, graph, stops);
+        // The last TAIL positions of a live prefix are scored as one SIMD batch
+        BatchEvaluator evaluator(n, graph, stops);
+        bool batched = n > PermutationWalk::TAIL;
+        const uint64_t tail_block = factorials[std::min(n, PermutationWalk::TAIL)];
+        std::vector<int> candidate;
+        auto improve = [&](int value, const std::vector<int> &path) {
+            local_min_max = value;
+            local_best_path = path;
+            thread_found_path = true;
+            log.improved(local_min_max);
+            int cur = shared_best.load();
+            while (local_min_max < cur && !shared_best.compare_exchange_weak(cur, local_min_max)) {
+            }
+        };
+        uint64_t first, last;
+        while (!time_up.load() && scheduler.claim(first, last)) {
+            if (deadline.expired()) {
+                time_up.store(true);
+                break;
+            }
+            // Only the first permutation of a range is unranked, the rest are
+            // lexicographic successors rescored from the first changed position
+            walk.seek(first, factorials);
+            for (uint64_t k = first; k < last;) {
+                int bound = std::min(local_min_max, shared_best.load(std::memory_order_relaxed));
+                int dead = walk.dead_prefix(bound);
+                if (batched && dead >= n - PermutationWalk::TAIL && k + tail_block <= last &&
+                    walk.block_start(n - 1 - PermutationWalk::TAIL)) {
+                    int value = walk.best_completion(evaluator, symmetric, candidate);
+                    if (value < bound) {
+                        improve(value, candidate);
+                    }
+                    k += tail_block;
+                    if (k >= last || !walk.skip(n - 1 - PermutationWalk::TAIL)) {
+                        break;
+                    }
+                    continue;
+                }
+                if (dead < n - 1) {
+                    uint64_t block = factorials[n - 1 - dead];
+                    k += block - k % block;
+                    if (k > last) {
+                        scheduler.skip_to(k);
+                    }
+                    if (k >= last || !walk.skip(dead)) {
+                        break;
+                    }
+                    continue;
+                }
+                const std::vector<int> &perm = walk.path();
 
-                // 4. Check if this path is better than the thread's current best
-                if (current_max_subpath < local_min_max) {
-                    local_min_max = current_max_subpath;
-                    // Copy the current permutation to the thread's best path buffer
-                    local_best_path = current_perm_buffer; 
-                    thread_found_path = true;
+                // Skip the reversed copy of a path already counted in its other orientation
+                if (dead == n && !(symmetric && perm[0] > perm[n - 1])) {
+                    improve(walk.value(), perm);
                 }
+                ++k;
+                walk.next();
             }
-        } 
+        }
 
         #pragma omp critical
         {
@@ -217,6 +304,13 @@ void find_min_max_path(Utils utils, int n, int **graph, bool *stops)
         std::cout << global_min_max << '\n';
     }
 
+    if (!shard.output.empty() &&
+        !write_shard(shard.output, instance, n, shard, !time_up.load(), global_min_max, global_best_path)) {
+        std::cerr << "Unable to write shard result to '" << shard.output << "'.\n";
+    }
+
+    report_status(deadline, time_up.load() ? RunStatus::TimeLimit : RunStatus::Optimal);
+
     // No need to delete hamiltonian_paths array as it was never created
     // global_best_path is a std::vector and cleans itself up
 }
@@ -249,14 +343,42 @@ int main(int argc, char *argv[])
         std::cerr << "path to data file not provided\n";
         return 1;
     }
+    double time_limit;
+    if (!parse_time_limit(utils.get_option(argc, argv, "time-limit", "0"), time_limit))
+    {
+        return 1;
+    }
+    Deadline deadline(time_limit);
     std::string test_data_path = argv[1];
     int n, s;
-    bool *stop_vertices;
+    int *stop_vertices;
     int **graph;
     utils.read_data_from_json_to_arrays(test_data_path, n, s, graph, stop_vertices);
+    bool *stops = new bool[n]();
+    for (int i = 0; i < s; ++i) {
+        stops[stop_vertices[i]] = true;
+    }
+
+    Shard shard;
+    std::string range = utils.get_option(argc, argv, "range");
+    if (!range.empty()) {
+        size_t colon = range.find(':');
+        try {
+            shard.begin = std::stoull(range.substr(0, colon));
+            if (colon != std::string::npos && colon + 1 < range.size()) {
+                shard.end = std::stoull(range.substr(colon + 1));
+            }
+        } catch (const std::exception &) {
+            std::cerr << "Invalid --range '" << range << "' (expected BEGIN:END)\n";
+            return 1;
+        }
+    }
+    shard.output = utils.get_option(argc, argv, "shard-output");
 
-    find_min_max_path(utils, n, graph, stop_vertices);
+    bool symmetric = !utils.has_option(argc, argv, "no-symmetry") && utils.is_symmetric_arrays(n, graph);
+    find_min_max_path(utils, n, graph, stops, symmetric, deadline, shard);
 
+    delete[] stops;
     utils.release_allocated_memory(n, graph, stop_vertices);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
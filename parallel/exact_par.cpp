@@ -1,5 +1,17 @@
 #include <nlohmann/json.hpp>
 #include "../utils.h"
+#include "../bottleneck_dp.h"
+#include "../bitset_graph.h"
+#include "../incumbent.h"
+#include "../exact_options.h"
+#include "../threshold_search.h"
+#include "../meet_in_middle.h"
+#include "../greedy.h"
+#include "../search_frame.h"
+#include "../checkpoint.h"
+#include "../anytime.h"
+#include "../distributed.h"
+#include "../lockstep_dp.h"
 #include <string>
 #include <iostream>
 #include <cstdlib>
@@ -8,7 +20,15 @@
 #include <climits>
 #include <filesystem>
 #include <omp.h>
-#include <atomic> // Można rozważyć dla min_max_subpath, ale critical jest prostsze
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <sstream>
+#include <map>
+#include <poll.h>
 
 using json = nlohmann::json;
 
@@ -34,131 +54,1109 @@ int max_subpath(int *path, int path_size, bool *stop_vertices_check, int **graph
   }
   return max_subpath;
 }
-// Zmodyfikowana funkcja check_all_possible_paths
-// Przyjmuje referencję do globalnego min_max_l i wskaźnik do globalnego opt_path
-// Wprowadzono sekcję krytyczną do aktualizacji globalnego optimum
-void check_all_possible_paths(int pos, int cur_l, int max_l, int used_s, int *path, bool *visited,
-                              int &min_max_l, int *opt_path, int n, int s, bool *stops, int **graph,
-                              omp_lock_t *lock) // Dodajemy blokadę jako argument
+// Stan ścieżki po dołożeniu wierzchołka v na pozycję pos (po prev).
+// Zwraca false, gdy gałąź jest odcinana (reguła przystanków lub min_max_l).
+bool extend_path(int pos, int prev, int v, int &cur_l, int &max_l, int &used_s,
+                 int min_max_l, int n, int s, bool *stops, int **graph)
 {
-  // Pruning na podstawie bieżącej ścieżki (max_l) i globalnego minimum (min_max_l)
-  // Odczyt min_max_l nie musi być chroniony, ale może być lekko nieaktualny.
-  // Jeśli chcemy najświeższą wartość, można użyć #pragma omp atomic read
-  // ale często nie jest to konieczne.
-  if (max_l >= min_max_l)
+  cur_l += graph[prev][v];
+  if (stops[v])
   {
-    return; // Przycinanie na podstawie już osiągniętego max_l
+    ++used_s;
+    // Sprawdzenie warunku liczby przystanków (jeśli jest wymagane 'dokładnie s')
+    if (used_s > s || (used_s == s && pos != n - 1))
+    {
+      return false; // Ścieżka nie spełnia warunków przystanków
+    }
+    if (max_l < cur_l)
+    {
+      // Porównujemy potencjalny nowy max_l (czyli cur_l) z globalnym min_max_l
+      if (cur_l >= min_max_l) // Odczyt min_max_l
+      {
+        return false; // Ta gałąź nie może dać lepszego wyniku
+      }
+      max_l = cur_l; // Aktualizuj max_l dla tej ścieżki
+    }
+    cur_l = 0; // Resetuj licznik długości podścieżki
   }
+  return true;
+}
+
+// Zadanie: niezbadane poddrzewo opisane prefiksem ścieżki i stanem po jego końcu
+// (ten sam opis co w pliku punktu kontrolnego, checkpoint.h)
+using Task = SubtreeRoot;
+
+// Kolejka zadań jednego wątku: właściciel bierze z końca (najgłębsze zadania),
+// złodzieje z początku (najpłytsze, czyli największe poddrzewa)
+struct TaskDeque
+{
+  std::deque<Task> tasks;
+  std::atomic<int> size{0};
+  omp_lock_t lock;
+
+  TaskDeque() { omp_init_lock(&lock); }
+  ~TaskDeque() { omp_destroy_lock(&lock); }
+};
+
+struct Scheduler
+{
+  std::vector<TaskDeque> deques;
+  std::atomic<long long> pending{0}; // zadania dodane, ale jeszcze nie zakończone
+  std::atomic<int> idle{0};          // wątki szukające pracy
+
+  // Punkt kontrolny (--checkpoint): gdy zegar minie, każdy wątek odkłada resztę
+  // swojego poddrzewa do własnej kolejki i czeka; ostatni z nich zapisuje plik
+  std::atomic<bool> checkpoint_due{false};
+  std::atomic<bool> time_up{false}; // minął --time-limit: reszta zadań zostaje w kolejkach
+  std::atomic<unsigned> checkpoint_epoch{0}; // liczba zapisanych punktów kontrolnych
+  omp_lock_t checkpoint_lock;
+  int running = 0; // wątki, które jeszcze nie skończyły pracy
+  int arrived = 0; // wątki czekające na zapis
 
-  if (pos == n)
+  explicit Scheduler(int n_threads) : deques(n_threads) { omp_init_lock(&checkpoint_lock); }
+  ~Scheduler() { omp_destroy_lock(&checkpoint_lock); }
+
+  void push(int tid, Task task)
+  {
+    pending.fetch_add(1);
+    TaskDeque &d = deques[tid];
+    omp_set_lock(&d.lock);
+    d.tasks.push_back(std::move(task));
+    d.size.store(d.tasks.size(), std::memory_order_relaxed);
+    omp_unset_lock(&d.lock);
+  }
+
+  bool take(int tid, int victim, Task &task)
   {
-    // Znaleziono kompletną ścieżkę, sprawdzamy czy jest lepsza
-    omp_set_lock(lock); // Zablokuj przed dostępem do współdzielonych zmiennych
-    if (max_l < min_max_l)
+    TaskDeque &d = deques[victim];
+    if (d.size.load(std::memory_order_relaxed) == 0)
     {
-      min_max_l = max_l;
-      std::copy(path, path + n, opt_path);
+      return false;
     }
-    omp_unset_lock(lock); // Odblokuj
-    return;
+    omp_set_lock(&d.lock);
+    bool found = !d.tasks.empty();
+    if (found)
+    {
+      if (victim == tid)
+      {
+        task = std::move(d.tasks.back());
+        d.tasks.pop_back();
+      }
+      else
+      {
+        task = std::move(d.tasks.front());
+        d.tasks.pop_front();
+      }
+      d.size.store(d.tasks.size(), std::memory_order_relaxed);
+    }
+    omp_unset_lock(&d.lock);
+    return found;
   }
 
-  for (int v = 0; v < n; v++)
+  bool next_task(int tid, Task &task)
   {
-    if (graph[path[pos - 1]][v] && !visited[v])
+    int n_deques = deques.size();
+    for (int i = 0; i < n_deques; ++i)
     {
-      path[pos] = v;
-      visited[v] = true;
-      int new_max_l = max_l;
-      int new_cur_l = cur_l + graph[path[pos - 1]][v];
-      int new_used_s = used_s;
+      if (take(tid, (tid + i) % n_deques, task))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// Lokalny stan wątku: bieżąca ścieżka, odwiedzone wierzchołki, kandydaci na
+// każdej głębokości oraz jawny stos ramek (search_frame.h) ze stanem
+// (cur_l, max_l, used_s) każdego węzła na ścieżce, dzięki czemu niezbadanych
+// braci można oddać innym wątkom jako zadania
+struct Worker
+{
+  int tid;
+  int base; // długość prefiksu bieżącego zadania
+  std::vector<int> path;
+  std::vector<uint64_t> visited;
+  std::vector<uint64_t> candidates;
+  std::vector<int> children; // kandydaci w kolejności opts.order, n na głębokość
+  std::vector<SearchFrame> frames;
+  ExactStats stats;
+
+  Worker(int tid, int n, int words)
+      : tid(tid), base(0), path(n), visited(words), candidates((n + 1) * words), children((n + 1) * n),
+        frames(n + 1) {}
+};
 
-      if (stops[v])
+// Gdy któryś wątek czeka na pracę, a nasza kolejka jest pusta, oddajemy
+// najpłycej położonego niezbadanego brata z bieżącej ścieżki
+void donate_shallowest_sibling(Worker &w, int pos, const Incumbent &best, int n, int s, bool *stops, int **graph,
+                               const BitsetGraph &bits, Scheduler &sched)
+{
+  for (int d = w.base; d <= pos; ++d)
+  {
+    uint64_t *cand = &w.candidates[d * bits.words];
+    for (int k = 0; k < bits.words; ++k)
+    {
+      // Bit bieżącego dziecka path[d] jest zerowany przed zejściem w głąb,
+      // więc w cand zostają tylko niezbadani bracia
+      uint64_t siblings = cand[k];
+      if (!siblings)
       {
-        ++new_used_s;
-        // Sprawdzenie warunku liczby przystanków (jeśli jest wymagane 'dokładnie s')
-        if (new_used_s > s || (new_used_s == s && pos != n - 1))
-        {
-          visited[v] = false;
-          continue; // Ścieżka nie spełnia warunków przystanków
-        }
+        continue;
+      }
+      int v = k * 64 + 63 - __builtin_clzll(siblings);
+      cand[k] &= ~(uint64_t(1) << (v % 64));
+      const SearchFrame &f = w.frames[d];
+      Task task{std::vector<int>(w.path.begin(), w.path.begin() + d), f.cur_l, f.max_l, f.used_s};
+      if (extend_path(d, w.path[d - 1], v, task.cur_l, task.max_l, task.used_s, best.bound(), n, s, stops, graph))
+      {
+        task.prefix.push_back(v);
+        sched.push(w.tid, std::move(task));
+      }
+      return;
+    }
+  }
+}
+
+// Odkłada niezbadaną część bieżącego zadania do własnej kolejki: niesprawdzonych
+// braci z ramek base..pos - 1 (najpłytszych najpierw) i na końcu sam węzeł pos,
+// więc po wznowieniu właściciel zaczyna od miejsca, w którym przerwał
+void spill_frontier(Worker &w, int pos, const Incumbent &best, int n, int s, bool *stops, int **graph,
+                    const BitsetGraph &bits, Scheduler &sched)
+{
+  for (int d = w.base; d < pos; ++d)
+  {
+    const SearchFrame &f = w.frames[d];
+    const uint64_t *cand = &w.candidates[d * bits.words];
+    for (int i = f.count - 1; i >= f.cursor; --i)
+    {
+      int v = w.children[d * n + i];
+      // Brat oddany wcześniej innemu wątkowi ma już wyzerowany bit
+      if (!BitsetGraph::test(cand, v))
+      {
+        continue;
+      }
+      Task task{std::vector<int>(w.path.begin(), w.path.begin() + d), f.cur_l, f.max_l, f.used_s};
+      if (extend_path(d, w.path[d - 1], v, task.cur_l, task.max_l, task.used_s, best.bound(), n, s, stops, graph))
+      {
+        task.prefix.push_back(v);
+        sched.push(w.tid, std::move(task));
+      }
+    }
+  }
+  const SearchFrame &f = w.frames[pos];
+  sched.push(w.tid, Task{std::vector<int>(w.path.begin(), w.path.begin() + pos), f.cur_l, f.max_l, f.used_s});
+}
 
-        if (new_max_l < new_cur_l)
+// Zapis punktu kontrolnego, gdy wszystkie pracujące wątki czekają: kolejki
+// zawierają wtedy całą niezbadaną część drzewa. Wołane z zajętym checkpoint_lock
+void write_checkpoint(Scheduler &sched, const Incumbent &best, Checkpoint &checkpoint, const std::string &file,
+                      CheckpointClock &clock)
+{
+  checkpoint.bound = best.snapshot(checkpoint.path.data());
+  checkpoint.frontier.clear();
+  for (TaskDeque &d : sched.deques)
+  {
+    omp_set_lock(&d.lock);
+    checkpoint.frontier.insert(checkpoint.frontier.end(), d.tasks.begin(), d.tasks.end());
+    omp_unset_lock(&d.lock);
+  }
+  if (!checkpoint.save(file))
+  {
+    std::cerr << "Unable to write checkpoint '" << file << "'.\n";
+  }
+  clock.restart();
+  sched.arrived = 0;
+  sched.checkpoint_due.store(false);
+  sched.checkpoint_epoch.fetch_add(1);
+}
+
+// Wątek bez bieżącego zadania zgłasza się do zapisu i czeka, aż ostatni z
+// pracujących wątków go wykona
+void wait_for_checkpoint(Scheduler &sched, const Incumbent &best, Checkpoint &checkpoint, const std::string &file,
+                         CheckpointClock &clock)
+{
+  omp_set_lock(&sched.checkpoint_lock);
+  // Zapis mógł się już odbyć, zanim dostaliśmy blokadę
+  if (!sched.checkpoint_due.load())
+  {
+    omp_unset_lock(&sched.checkpoint_lock);
+    return;
+  }
+  unsigned epoch = sched.checkpoint_epoch.load();
+  if (++sched.arrived == sched.running)
+  {
+    write_checkpoint(sched, best, checkpoint, file, clock);
+  }
+  omp_unset_lock(&sched.checkpoint_lock);
+  while (sched.checkpoint_epoch.load() == epoch)
+  {
+    std::this_thread::yield();
+  }
+}
+
+// Wątek kończący pracę nie będzie już czekał na zapis; jeśli reszta już czeka,
+// zapisuje go sam
+void leave_search(Scheduler &sched, const Incumbent &best, Checkpoint &checkpoint, const std::string &file,
+                  CheckpointClock *clock)
+{
+  omp_set_lock(&sched.checkpoint_lock);
+  --sched.running;
+  if (clock && sched.checkpoint_due.load() && sched.running > 0 && sched.arrived == sched.running)
+  {
+    write_checkpoint(sched, best, checkpoint, file, *clock);
+  }
+  omp_unset_lock(&sched.checkpoint_lock);
+}
+
+// Zmodyfikowana funkcja check_all_possible_paths
+// Globalne optimum (best) jest współdzielone bez blokad: próg odczytywany jest
+// atomowo (relaxed), a poprawa to CAS-min z publikacją ścieżki przez seqlock
+// Sąsiedzi są wybierani z reprezentacji bitowej: w.candidates to wiersz słów na
+// każdą głębokość (nieodwiedzeni sąsiedzi path[pos - 1] do sprawdzenia), a
+// przeglądani są w kolejności wyznaczonej przez order (--order)
+// Przeszukiwanie jest iteracyjne: w.frames[pos] to węzeł, którego ścieżka ma pos
+// wierzchołków; funkcja wraca po wyczerpaniu węzła startowego, odwiedzając
+// węzły w tej samej kolejności co wersja rekurencyjna
+// Funkcja wraca też wtedy, gdy należny jest zapis punktu kontrolnego (clock) lub
+// minął czas (deadline) - po odłożeniu reszty zadania do kolejki (spill_frontier)
+void check_all_possible_paths(int pos, int cur_l, int max_l, int used_s, Worker &w,
+                              Incumbent &best, int n, int s, bool *stops, int **graph,
+                              const BitsetGraph &bits, const ChildOrder &order, TranspositionTable *tt,
+                              Scheduler &sched, CheckpointClock *clock, const Deadline &deadline,
+                              IncumbentLog &log, const ExactOptions &opts)
+{
+  int base = pos;
+  w.frames[pos] = {0, 0, cur_l, max_l, used_s};
+  bool entering = true;
+  while (true)
+  {
+    SearchFrame &f = w.frames[pos];
+    uint64_t *cand = &w.candidates[pos * bits.words];
+    if (entering)
+    {
+      entering = false;
+      if (pos > base)
+      {
+        if ((w.stats.nodes & 0xfff) == 0)
         {
-          // Sprawdzenie przycinania *przed* rekurencyjnym wywołaniem
-          // Porównujemy potencjalny nowy max_l (czyli new_cur_l) z globalnym min_max_l
-          if (new_cur_l >= min_max_l) // Odczyt min_max_l
+          if (clock && clock->expired())
           {
-            visited[v] = false;
-            continue; // Ta gałąź nie może dać lepszego wyniku
+            sched.checkpoint_due.store(true);
           }
-          new_max_l = new_cur_l; // Aktualizuj max_l dla tej ścieżki
+          if (deadline.expired())
+          {
+            sched.time_up.store(true);
+          }
+        }
+        if (sched.checkpoint_due.load(std::memory_order_relaxed) || sched.time_up.load(std::memory_order_relaxed))
+        {
+          spill_frontier(w, pos, best, n, s, stops, graph, bits, sched);
+          return;
+        }
+      }
+      ++w.stats.nodes;
+
+      // Pruning na podstawie bieżącej ścieżki (max_l) i globalnego minimum
+      if (f.max_l >= best.bound())
+      {
+        // Przycinanie na podstawie już osiągniętego max_l
+      }
+      else if (pos == n)
+      {
+        // Znaleziono kompletną ścieżkę - zostanie opublikowana, jeśli jest lepsza
+        if (best.offer(f.max_l, w.path.data()))
+        {
+          log.improved(f.max_l);
         }
-        new_cur_l = 0; // Resetuj licznik długości podścieżki
       }
-      // Kontynuuj rekurencję z zaktualizowanymi wartościami
-      // Przekazujemy te same globalne zmienne min_max_l i opt_path oraz blokadę
-      check_all_possible_paths(pos + 1, new_cur_l, new_max_l, new_used_s, path, visited, min_max_l, opt_path, n, s, stops, graph, lock);
-      visited[v] = false; // Backtracking
+      // Ścieżki odwrócone: ścieżka od przystanku musi skończyć się na nieodwiedzonym
+      // przystanku o numerze większym niż path[0] (ścieżki od zwykłych wierzchołków
+      // nie mają poprawnej odwrotności, więc są przeszukiwane bez ograniczeń)
+      else if (opts.symmetry && stops[w.path[0]] && !bits.has_unvisited_stop_above(w.path[0], w.visited.data()))
+      {
+        ++w.stats.symmetry_cuts;
+      }
+      // Opcjonalnie: odcinamy węzeł, gdy nieodwiedzone wierzchołki nie są już osiągalne z końca ścieżki
+      else if (opts.connectivity_every > 0 && pos % opts.connectivity_every == 0 &&
+               !bits.reaches_unvisited(w.path[pos - 1], w.visited.data()))
+      {
+        ++w.stats.connectivity_cuts;
+      }
+      // Wspólna tablica transpozycji (--tt-mb): węzeł jest rozwijany, chyba że ten sam
+      // zbiór odwiedzonych i ostatni wierzchołek był już osiągnięty z nie większymi max_l i cur_l
+      else if (!tt || pos < 2 || pos > n - 2 ||
+               !tt->dominated(w.visited[0], w.path[pos - 1], f.used_s, f.max_l, f.cur_l,
+                              opts.symmetry && stops[w.path[0]] ? w.path[0] + 1 : 0, w.stats.tt))
+      {
+        bits.candidates(w.path[pos - 1], w.visited.data(), cand);
+        f.count = order.order(w.path[pos - 1], cand, w.visited.data(), bits, &w.children[pos * n]);
+      }
     }
+    if (f.cursor == f.count)
+    {
+      if (pos == base)
+      {
+        return;
+      }
+      --pos;
+      BitsetGraph::reset(w.visited.data(), w.path[pos]); // Backtracking
+      continue;
+    }
+    int v = w.children[pos * n + f.cursor++];
+    // Bit w cand jest już wyzerowany, jeśli oddaliśmy tego brata innemu wątkowi
+    if (!BitsetGraph::test(cand, v))
+    {
+      continue;
+    }
+    BitsetGraph::reset(cand, v);
+    w.path[pos] = v;
+    int new_max_l = f.max_l;
+    int new_cur_l = f.cur_l;
+    int new_used_s = f.used_s;
+    if (!extend_path(pos, w.path[pos - 1], v, new_cur_l, new_max_l, new_used_s, best.bound(), n, s, stops, graph))
+    {
+      continue;
+    }
+    if (sched.idle.load(std::memory_order_relaxed) > 0 &&
+        sched.deques[w.tid].size.load(std::memory_order_relaxed) == 0)
+    {
+      donate_shallowest_sibling(w, pos, best, n, s, stops, graph, bits, sched);
+    }
+    // Zejście w głąb z zaktualizowanymi wartościami
+    BitsetGraph::set(w.visited.data(), v);
+    ++pos;
+    w.frames[pos] = {0, 0, new_cur_l, new_max_l, new_used_s};
+    entering = true;
   }
 }
 
+// Początkowe zadania: wszystkie poprawne prefiksy o długości split_depth
+void generate_tasks(std::vector<int> &prefix, int cur_l, int max_l, int used_s, int split_depth,
+                    int n, int s, bool *stops, int **graph, std::vector<Task> &tasks)
+{
+  int pos = prefix.size();
+  if (pos == split_depth)
+  {
+    tasks.push_back(Task{prefix, cur_l, max_l, used_s});
+    return;
+  }
+  for (int v = 0; v < n; ++v)
+  {
+    if (std::find(prefix.begin(), prefix.end(), v) != prefix.end() || (pos > 0 && !graph[prefix.back()][v]))
+    {
+      continue;
+    }
+    int new_cur_l = cur_l, new_max_l = max_l, new_used_s = used_s;
+    if (pos == 0)
+    {
+      new_used_s = stops[v] ? 1 : 0;
+    }
+    else if (!extend_path(pos, prefix.back(), v, new_cur_l, new_max_l, new_used_s, INT_MAX, n, s, stops, graph))
+    {
+      continue;
+    }
+    prefix.push_back(v);
+    generate_tasks(prefix, new_cur_l, new_max_l, new_used_s, split_depth, n, s, stops, graph, tasks);
+    prefix.pop_back();
+  }
+}
+
+// Przeszukuje wszystkie zadania z kolejek sched wątkami OpenMP: każdy wątek
+// bierze zadania najpierw z własnej kolejki, potem kradnie z cudzych. Wraca, gdy
+// zadań nie ma (albo minął czas - wtedy reszta zostaje w kolejkach)
+void search_tasks(Scheduler &sched, Incumbent &best, int n, int s, bool *stops, int **graph, const BitsetGraph &bits,
+                  const ChildOrder &order, TranspositionTable *tt, CheckpointClock *clock, Checkpoint &checkpoint,
+                  const Deadline &deadline, IncumbentLog &log, const ExactOptions &opts, ExactStats &stats)
+{
+#pragma omp parallel shared(graph, stops, n, s, best, bits, order, tt, sched, clock, checkpoint, deadline, log, opts, stats)
+  {
+    // Każdy wątek ma swoje lokalne kopie do eksploracji
+    Worker w(omp_get_thread_num(), n, bits.words);
+    bool idle = false;
+    Task task;
+#pragma omp single
+    sched.running = omp_get_num_threads();
+    while (true)
+    {
+      // Po upływie czasu nie bierzemy nowych zadań
+      if (sched.time_up.load() || deadline.expired())
+      {
+        sched.time_up.store(true);
+        break;
+      }
+      if (clock && sched.checkpoint_due.load())
+      {
+        wait_for_checkpoint(sched, best, checkpoint, opts.checkpoint, *clock);
+        continue;
+      }
+      if (sched.next_task(w.tid, task))
+      {
+        if (idle)
+        {
+          sched.idle.fetch_sub(1);
+          idle = false;
+        }
+        int len = task.prefix.size();
+        std::copy(task.prefix.begin(), task.prefix.end(), w.path.begin());
+        std::fill(w.visited.begin(), w.visited.end(), 0);
+        for (int v : task.prefix)
+        {
+          BitsetGraph::set(w.visited.data(), v);
+        }
+        w.base = len;
+        // Wywołujemy rekurencję, przekazując GLOBALNE optimum
+        check_all_possible_paths(len, task.cur_l, task.max_l, task.used_s, w, best,
+                                 n, s, stops, graph, bits, order, tt, sched, clock, deadline, log, opts);
+        sched.pending.fetch_sub(1);
+        continue;
+      }
+      if (sched.pending.load() == 0)
+      {
+        break;
+      }
+      if (!idle)
+      {
+        sched.idle.fetch_add(1);
+        idle = true;
+      }
+      std::this_thread::yield();
+    }
+    if (idle)
+    {
+      sched.idle.fetch_sub(1);
+    }
+    leave_search(sched, best, checkpoint, opts.checkpoint, clock);
+#pragma omp critical
+    stats.add(w.stats);
+  } // Koniec regionu równoległego
+}
+
 // Zmodyfikowana funkcja solve
-int *solve(int n, int s, int **graph, bool *stop_vertices_check, int n_threads = 8)
+// Zamiast n zadań (po jednym na wierzchołek startowy) drzewo przeszukiwania jest
+// dzielone na prefiksy długości split_depth, a bezczynne wątki kradną
+// najpłytsze niezbadane poddrzewa z kolejek pozostałych wątków
+// checkpoint niesie skrót instancji, a przy --resume zapisane przeszukiwanie,
+// którego zadania trafiają do kolejek zamiast prefiksów z generate_tasks
+// proven jest fałszywe, gdy przeszukiwanie przerwał --time-limit
+int *solve(int n, int s, int **graph, bool *stop_vertices_check, const ExactOptions &opts, ExactStats &stats,
+           Checkpoint &checkpoint, const Deadline &deadline, bool &proven, int n_threads = 8, int split_depth = 1)
 {
-  int *opt_path = new int[n];
-  // Inicjalizacja globalnego minimum - można użyć std::atomic<int> jeśli chcemy unikać blokad przy odczycie
-  int min_max_subpath = INT_MAX;
+  IncumbentLog log(deadline);
+
+  // Globalne optimum współdzielone przez wątki bez blokad
+  Incumbent best(n);
+
+  // Ścieżka z algorytmu zachłannego (jeśli jest) to pierwsze optimum - od początku ogranicza drzewo
+  std::vector<int> warm_path(n);
+  stats.warm_start = greedy_warm_start(n, s, graph, stop_vertices_check, opts.warm_start_ms, warm_path.data());
+  if (stats.warm_start != INT_MAX)
+  {
+    best.offer(stats.warm_start, warm_path.data());
+    log.improved(stats.warm_start);
+  }
+  if (opts.resume && checkpoint.bound != INT_MAX)
+  {
+    best.offer(checkpoint.bound, checkpoint.path.data());
+    log.improved(checkpoint.bound);
+  }
 
   omp_set_num_threads(n_threads);
 
-  // Inicjalizacja blokady OpenMP
-  omp_lock_t writelock;
-  omp_init_lock(&writelock);
+  BitsetGraph bits(n, graph, stop_vertices_check);
+  ChildOrder order(n, graph, stop_vertices_check, opts.order);
+  std::unique_ptr<TranspositionTable> tt(opts.tt_mb > 0 ? new TranspositionTable(opts.tt_mb) : nullptr);
+  std::unique_ptr<CheckpointClock> clock(opts.checkpoint.empty() ? nullptr
+                                                                 : new CheckpointClock(opts.checkpoint_every));
+  checkpoint.path.resize(n);
+  std::vector<Task> tasks;
+  if (opts.resume)
+  {
+    tasks = std::move(checkpoint.frontier);
+  }
+  else
+  {
+    std::vector<int> prefix;
+    generate_tasks(prefix, 0, 0, 0, std::max(1, std::min(split_depth, n)), n, s, stop_vertices_check, graph, tasks);
+  }
+  Scheduler sched(n_threads);
+  for (size_t i = 0; i < tasks.size(); ++i)
+  {
+    sched.push(i % sched.deques.size(), std::move(tasks[i]));
+  }
+
+  search_tasks(sched, best, n, s, stop_vertices_check, graph, bits, order, tt.get(), clock.get(), checkpoint, deadline,
+               log, opts, stats);
 
-// Usunięto 'shared(opt_path, min_max_subpath)' - dostęp będzie zarządzany przez blokadę
-// Usunięto 'private(chunk_size)' - nie jest używane w pętli for
-#pragma omp parallel shared(graph, stop_vertices_check, n, s, min_max_subpath, opt_path, writelock)
+  proven = sched.pending.load() == 0;
+  // Ostatni stan też jest zapisywany: wznowienie zakończonego przeszukiwania od
+  // razu wypisze wynik, a przerwanego przez --time-limit - dokończy je
+  if (clock)
   {
-    // Każdy wątek ma swoje lokalne kopie do eksploracji
-    int *path = new int[n];
-    bool *visited = new bool[n];
+    write_checkpoint(sched, best, checkpoint, opts.checkpoint, *clock);
+  }
 
-// Pętla for bez lokalnych zmiennych min/opt - operuje na globalnych
-// Usunięto 'private(path, visited, local_opt_path, local_min_max)' - path i visited są lokalne wątku, reszta globalna
-// schedule(dynamic) może być dobrym wyborem przy nierównomiernym czasie obliczeń dla różnych 'i'
-#pragma omp for schedule(dynamic)
-    for (int i = 0; i < n; ++i)
+  // Sprawdzenie, czy znaleziono jakiekolwiek rozwiązanie
+  int *opt_path = new int[n];
+  if (best.snapshot(opt_path) == INT_MAX)
+  {
+    delete[] opt_path;
+    return nullptr;
+  }
+  return opt_path;
+}
+
+// Czy path jest poprawną ścieżką według reguł check_all_possible_paths
+// (hamiltonowska, kończy się przystankiem); jeśli tak, value to jej wartość
+bool valid_path(const std::vector<int> &path, int n, bool *stops, int **graph, int &value)
+{
+  std::vector<bool> seen(n, false);
+  for (int i = 0; i < n; ++i)
+  {
+    if (seen[path[i]] || (i > 0 && !graph[path[i - 1]][path[i]]))
     {
-      std::fill(visited, visited + n, false);
-      visited[i] = true;
-      path[0] = i;
+      return false;
+    }
+    seen[path[i]] = true;
+  }
+  value = max_subpath(const_cast<int *>(path.data()), n, stops, graph);
+  return stops[path[n - 1]];
+}
+
+// Koordynator (--coordinator PORT): dzieli drzewo na prefiksy długości
+// split_depth i rozdaje je procesom roboczym (--worker), sam nie przeszukuje.
+// Poprawę optimum zgłoszoną przez proces roboczy sprawdza i rozsyła do
+// wszystkich pozostałych. Zadanie procesu, który się rozłączył, wraca do kolejki
+int *coordinate(int n, int s, int **graph, bool *stops, const ExactOptions &opts, ExactStats &stats, int listener,
+                int split_depth, const Deadline &deadline, bool &proven)
+{
+  struct Peer
+  {
+    std::unique_ptr<Connection> conn;
+    bool greeted = false;
+    bool waiting = false; // wysłał GET i czeka na zadanie
+    bool has_job = false;
+    bool closed = false;
+    Task job;
+  };
+
+  IncumbentLog log(deadline);
+  uint64_t instance = instance_hash(n, s, graph, stops, "exact_par");
+  std::vector<int> best_path(n);
+  int best = stats.warm_start = greedy_warm_start(n, s, graph, stops, opts.warm_start_ms, best_path.data());
+  log.improved(best);
 
-      // Wywołujemy rekurencję, przekazując GLOBALNE min_max_subpath, opt_path i blokadę
-      check_all_possible_paths(1, 0, 0, (stop_vertices_check[i] ? 1 : 0), path, visited,
-                               min_max_subpath, opt_path,
-                               n, s, stop_vertices_check, graph, &writelock);
-      // Nie potrzebujemy już lokalnego agregowania wyników ani sekcji krytycznej tutaj
-      // Aktualizacje globalnego optimum dzieją się wewnątrz check_all_possible_paths
+  std::vector<Task> tasks;
+  std::vector<int> prefix;
+  generate_tasks(prefix, 0, 0, 0, std::max(1, std::min(split_depth, n)), n, s, stops, graph, tasks);
+  std::deque<Task> jobs(std::make_move_iterator(tasks.begin()), std::make_move_iterator(tasks.end()));
+  int in_flight = 0, workers = 0, requeued = 0;
+  std::vector<Peer> peers;
+
+  auto send = [](Peer &peer, const std::string &line)
+  {
+    if (!peer.conn->send_line(line))
+    {
+      peer.closed = true;
     }
-    // Sprzątanie pamięci lokalnej wątku
-    delete[] path;
-    delete[] visited;
-  } // Koniec regionu równoległego
+  };
+  auto handle = [&](Peer &peer, const std::string &line)
+  {
+    std::istringstream in(line);
+    std::string keyword;
+    in >> keyword;
+    if (keyword == "HELLO")
+    {
+      uint64_t hash = 0;
+      in >> hash;
+      if (hash != instance)
+      {
+        std::cerr << "worker rejected: it solves another instance\n";
+        send(peer, "BYE");
+        peer.closed = true;
+        return;
+      }
+      peer.greeted = true;
+      ++workers;
+      if (best != INT_MAX)
+      {
+        send(peer, format_path("BOUND", best, best_path.data(), n));
+      }
+    }
+    else if (keyword == "GET" && peer.greeted)
+    {
+      if (peer.has_job)
+      {
+        peer.has_job = false;
+        --in_flight;
+      }
+      peer.waiting = true;
+    }
+    else if (keyword == "IMPROVE" && peer.greeted)
+    {
+      int claimed, value;
+      std::vector<int> path;
+      if (!parse_path(in, n, claimed, path) || !valid_path(path, n, stops, graph, value) || value >= best)
+      {
+        return;
+      }
+      best = value;
+      best_path = path;
+      log.improved(best);
+      std::string bound = format_path("BOUND", best, best_path.data(), n);
+      for (Peer &other : peers)
+      {
+        if (&other != &peer && other.greeted && !other.closed)
+        {
+          send(other, bound);
+        }
+      }
+    }
+  };
 
-  // Zniszczenie blokady
-  omp_destroy_lock(&writelock);
+  while (!deadline.expired() && (!jobs.empty() || in_flight > 0))
+  {
+    std::vector<pollfd> fds(1, pollfd{listener, POLLIN, 0});
+    for (Peer &peer : peers)
+    {
+      fds.push_back(pollfd{peer.conn->descriptor(), POLLIN, 0});
+    }
+    if (poll(fds.data(), fds.size(), 100) < 0)
+    {
+      continue;
+    }
+    for (size_t i = 0; i < peers.size(); ++i)
+    {
+      Peer &peer = peers[i];
+      if (!(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+      {
+        continue;
+      }
+      if (!peer.conn->receive())
+      {
+        peer.closed = true;
+      }
+      std::string line;
+      while (!peer.closed && peer.conn->pop_line(line))
+      {
+        handle(peer, line);
+      }
+    }
+    if (fds[0].revents & POLLIN)
+    {
+      int fd = accept(listener, nullptr, nullptr);
+      if (fd >= 0)
+      {
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        peers.push_back(Peer());
+        peers.back().conn.reset(new Connection(fd));
+      }
+    }
+    // Rozdanie zadań czekającym procesom
+    for (Peer &peer : peers)
+    {
+      if (peer.waiting && !peer.closed && !jobs.empty())
+      {
+        peer.job = std::move(jobs.front());
+        jobs.pop_front();
+        peer.waiting = false;
+        peer.has_job = true;
+        ++in_flight;
+        send(peer, format_job(peer.job));
+      }
+    }
+    // Zadania rozłączonych procesów wracają do kolejki
+    for (Peer &peer : peers)
+    {
+      if (peer.closed && peer.has_job)
+      {
+        jobs.push_front(std::move(peer.job));
+        peer.has_job = false;
+        --in_flight;
+        ++requeued;
+      }
+    }
+    peers.erase(std::remove_if(peers.begin(), peers.end(), [](const Peer &peer) { return peer.closed; }),
+                peers.end());
+  }
+  proven = jobs.empty() && in_flight == 0;
+  for (Peer &peer : peers)
+  {
+    send(peer, "DONE");
+  }
+  if (opts.stats)
+  {
+    std::cerr << "distributed jobs " << tasks.size() << ", workers " << workers << ", requeued " << requeued
+              << "\n";
+  }
 
-  // Sprawdzenie, czy znaleziono jakiekolwiek rozwiązanie
-  if (min_max_subpath == INT_MAX)
+  if (best == INT_MAX)
   {
-    delete[] opt_path;
     return nullptr;
   }
+  int *opt_path = new int[n];
+  std::copy(best_path.begin(), best_path.end(), opt_path);
   return opt_path;
 }
 
+// Proces roboczy (--worker HOST:PORT): pobiera zadania od koordynatora i
+// przeszukuje każde wszystkimi wątkami (search_tasks). Wątek sieciowy wpisuje
+// do best globalne optimum (BOUND), a lokalne poprawy są odsyłane jako IMPROVE -
+// od razu przez wątek raportujący i zawsze przed prośbą o następne zadanie
+int run_worker(int n, int s, int **graph, bool *stops, const ExactOptions &opts, ExactStats &stats,
+               const std::string &address, int n_threads)
+{
+  // Koordynator mógł jeszcze nie wystartować - próbujemy przez kilka sekund
+  int fd = connect_to(address);
+  for (int attempt = 0; fd < 0 && attempt < 50; ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    fd = connect_to(address);
+  }
+  Connection conn(fd);
+  if (!conn.open())
+  {
+    std::cerr << "Unable to connect to coordinator '" << address << "'.\n";
+    return 1;
+  }
+  conn.send_line("HELLO " + std::to_string(instance_hash(n, s, graph, stops, "exact_par")));
+
+  Incumbent best(n);
+  std::atomic<int> reported{INT_MAX}; // najlepsza wartość znana koordynatorowi
+  std::mutex send_mutex;
+  auto report = [&]()
+  {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    std::vector<int> path(n);
+    int value = best.snapshot(path.data());
+    if (value < reported.load())
+    {
+      reported.store(value);
+      conn.send_line(format_path("IMPROVE", value, path.data(), n));
+    }
+  };
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::deque<Task> jobs;
+  bool finished = false, rejected = false;
+  Scheduler *active = nullptr; // kolejki bieżącego zadania, by DONE mogło je przerwać
+  std::thread reader([&]()
+  {
+    std::string line;
+    std::vector<int> path;
+    while (conn.read_line(line))
+    {
+      std::istringstream in(line);
+      std::string keyword;
+      in >> keyword;
+      int value;
+      Task job;
+      if (keyword == "BOUND" && parse_path(in, n, value, path))
+      {
+        // Najpierw reported, żeby wątek raportujący nie odesłał tego samego optimum
+        int cur = reported.load();
+        while (value < cur && !reported.compare_exchange_weak(cur, value))
+        {
+        }
+        best.offer(value, path.data());
+      }
+      else if (keyword == "JOB" && parse_job(in, n, job))
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+        ready.notify_all();
+      }
+      else if (keyword == "DONE" || keyword == "BYE")
+      {
+        rejected = keyword == "BYE";
+        break;
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    if (active)
+    {
+      active->time_up.store(true);
+    }
+    ready.notify_all();
+  });
+  std::atomic<bool> stopping{false};
+  std::thread reporter([&]()
+  {
+    while (!stopping.load())
+    {
+      report();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  });
+
+  omp_set_num_threads(n_threads);
+  BitsetGraph bits(n, graph, stops);
+  ChildOrder order(n, graph, stops, opts.order);
+  // Tablica transpozycji przeżywa kolejne zadania: optimum tylko maleje, więc jej wpisy pozostają poprawne
+  std::unique_ptr<TranspositionTable> tt(opts.tt_mb > 0 ? new TranspositionTable(opts.tt_mb) : nullptr);
+  Deadline no_deadline;
+  IncumbentLog log(no_deadline);
+  Checkpoint no_checkpoint;
+  int jobs_done = 0;
+  while (true)
+  {
+    report();
+    {
+      std::lock_guard<std::mutex> lock(send_mutex);
+      conn.send_line("GET");
+    }
+    Scheduler sched(n_threads);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ready.wait(lock, [&]() { return finished || !jobs.empty(); });
+      if (finished)
+      {
+        break;
+      }
+      sched.push(0, std::move(jobs.front()));
+      jobs.pop_front();
+      active = &sched;
+    }
+    search_tasks(sched, best, n, s, stops, graph, bits, order, tt.get(), nullptr, no_checkpoint, no_deadline, log,
+                 opts, stats);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      active = nullptr;
+      if (finished)
+      {
+        break;
+      }
+    }
+    ++jobs_done;
+  }
+  stopping.store(true);
+  reporter.join();
+  shutdown(conn.descriptor(), SHUT_RDWR);
+  reader.join();
+  if (rejected)
+  {
+    std::cerr << "coordinator rejected the worker: it solves another instance\n";
+    return 1;
+  }
+  std::cerr << "worker searched " << jobs_done << " jobs\n";
+  return 0;
+}
+
+// Instancja trybu wsadowego i wiersz wyniku, który dla niej powstał
+struct BatchEntry
+{
+  std::string name;
+  int n = 0, s = 0;
+  int **graph = nullptr;
+  int *stop_vertices = nullptr;
+  bool *stops = nullptr;
+  std::string result;
+};
+
+std::string batch_result(const BatchEntry &e, const int *path)
+{
+  std::ostringstream out;
+  out << e.name;
+  if (!path)
+  {
+    out << " -1";
+    return out.str();
+  }
+  for (int i = 0; i < e.n; ++i)
+  {
+    out << ' ' << path[i];
+  }
+  out << ' ' << max_subpath(const_cast<int *>(path), e.n, e.stops, e.graph);
+  return out.str();
+}
+
+// Tryb wsadowy (--batch): wiele małych instancji w jednym procesie, bez
+// osobnego uruchomienia i wczytywania dla każdej. Wejście to katalog plików
+// .json albo plik JSON Lines (instancja w linii, nazwa z pola "name" lub numer
+// linii). Instancje do LockstepDP::MAX_VERTICES wierzchołków z co najmniej
+// dwoma przystankami są grupowane po n w paczki po LockstepDP::LANES i liczone
+// razem, po jednej na linię wektora; wątki biorą całe paczki. Resztę rozwiązuje
+// zwykły solve(). Wyniki trafiają do jednego pliku (lub na stdout), w kolejności
+// wejścia: "<nazwa> <ścieżka...> <wartość>", "<nazwa> -1" albo "<nazwa> -2"
+int run_batch(const std::string &input, const std::string &output, const ExactOptions &opts, int n_threads)
+{
+  auto started = std::chrono::steady_clock::now();
+  std::vector<std::string> texts;
+  std::vector<BatchEntry> entries;
+  if (std::filesystem::is_directory(input))
+  {
+    std::vector<std::filesystem::path> files;
+    for (const auto &file : std::filesystem::directory_iterator(input))
+    {
+      if (file.path().extension() == ".json")
+      {
+        files.push_back(file.path());
+      }
+    }
+    std::sort(files.begin(), files.end());
+    for (const auto &file : files)
+    {
+      std::ifstream in(file);
+      texts.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      entries.emplace_back();
+      entries.back().name = file.filename().string();
+    }
+  }
+  else
+  {
+    std::ifstream in(input);
+    if (!in)
+    {
+      std::cerr << "Unable to open batch input '" << input << "'.\n";
+      return 1;
+    }
+    std::string line;
+    for (int number = 1; std::getline(in, line); ++number)
+    {
+      if (line.find_first_not_of(" \t\r") == std::string::npos)
+      {
+        continue;
+      }
+      texts.push_back(line);
+      entries.emplace_back();
+      entries.back().name = std::to_string(number);
+    }
+  }
+
+  // Parsowanie JSON kosztuje przy małych instancjach tyle co ich rozwiązanie
+  omp_set_num_threads(n_threads);
+  std::atomic<int> broken{-1};
+#pragma omp parallel for schedule(dynamic, 64)
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    BatchEntry &e = entries[i];
+    try
+    {
+      json data = json::parse(texts[i]);
+      if (data.contains("name"))
+      {
+        e.name = data["name"].get<std::string>();
+      }
+      Utils::read_instance(data, e.n, e.s, e.graph, e.stop_vertices);
+      e.stops = new bool[e.n]();
+      for (int j = 0; j < e.s; ++j)
+      {
+        e.stops[e.stop_vertices[j]] = true;
+      }
+    }
+    catch (const std::exception &)
+    {
+      broken.store(i);
+    }
+  }
+  if (broken.load() >= 0)
+  {
+    std::cerr << "Unable to read instance '" << entries[broken.load()].name << "' of the batch.\n";
+    return 1;
+  }
+
+  // Paczki instancji o tym samym n dla LockstepDP, reszta dla solve()
+  std::map<int, std::vector<int>> by_size;
+  std::vector<int> others;
+  for (size_t i = 0; i < entries.size(); ++i)
+  {
+    BatchEntry &e = entries[i];
+    if (!Utils::is_connected_arrays(e.n, e.graph))
+    {
+      e.result = e.name + " -2";
+    }
+    else if (e.n >= 2 && e.n <= LockstepDP::MAX_VERTICES && e.s >= 2)
+    {
+      by_size[e.n].push_back(i);
+    }
+    else
+    {
+      others.push_back(i);
+    }
+  }
+  std::vector<std::vector<int>> batches;
+  for (const auto &group : by_size)
+  {
+    for (size_t first = 0; first < group.second.size(); first += LockstepDP::LANES)
+    {
+      size_t last = std::min(group.second.size(), first + LockstepDP::LANES);
+      batches.emplace_back(group.second.begin() + first, group.second.begin() + last);
+    }
+  }
+#pragma omp parallel
+  {
+    // Tablice DP każdego rozmiaru są alokowane raz na wątek
+    std::vector<std::unique_ptr<LockstepDP>> dp(LockstepDP::MAX_VERTICES + 1);
+    LaneInstance lanes[LockstepDP::LANES];
+    int values[LockstepDP::LANES];
+    std::vector<int> paths[LockstepDP::LANES];
+#pragma omp for schedule(dynamic)
+    for (size_t b = 0; b < batches.size(); ++b)
+    {
+      const std::vector<int> &batch = batches[b];
+      int n = entries[batch[0]].n;
+      if (!dp[n])
+      {
+        dp[n].reset(new LockstepDP(n, false));
+      }
+      for (size_t l = 0; l < batch.size(); ++l)
+      {
+        const BatchEntry &e = entries[batch[l]];
+        lanes[l] = {e.n, e.graph, e.stops};
+      }
+      dp[n]->solve(lanes, batch.size(), values, paths);
+      for (size_t l = 0; l < batch.size(); ++l)
+      {
+        BatchEntry &e = entries[batch[l]];
+        e.result = batch_result(e, values[l] == INT_MAX ? nullptr : paths[l].data());
+      }
+    }
+  }
+  for (int i : others)
+  {
+    BatchEntry &e = entries[i];
+    ExactStats stats;
+    Checkpoint checkpoint;
+    Deadline no_deadline;
+    bool proven;
+    // Te same poprawki opcji co w main() dla pojedynczej instancji
+    ExactOptions entry_opts = opts;
+    entry_opts.symmetry = opts.symmetry && e.s >= 2 && Utils::is_symmetric_arrays(e.n, e.graph);
+    if (!TranspositionTable::supports(e.n))
+    {
+      entry_opts.tt_mb = 0;
+    }
+    int *solution = solve(e.n, e.s, e.graph, e.stops, entry_opts, stats, checkpoint, no_deadline, proven, n_threads);
+    e.result = batch_result(e, solution);
+    delete[] solution;
+  }
+
+  std::ofstream file;
+  if (!output.empty())
+  {
+    file.open(output);
+    if (!file)
+    {
+      std::cerr << "Unable to write batch results to '" << output << "'.\n";
+      return 1;
+    }
+  }
+  std::ostream &out = output.empty() ? std::cout : file;
+  for (BatchEntry &e : entries)
+  {
+    out << e.result << '\n';
+    Utils::release_allocated_memory(e.n, e.graph, e.stop_vertices);
+    delete[] e.stops;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  std::fprintf(stderr, "batch: %zu instances (%zu in lockstep) in %.3f s, %.0f instances/s\n", entries.size(),
+               entries.size() - others.size(), seconds, entries.size() / std::max(seconds, 1e-9));
+  return 0;
+}
+
 // Funkcja main pozostaje bez zmian, poza ewentualnym uwzględnieniem zmian w solve (np. brak chunk_size)
 int main(int argc, char **argv)
 {
@@ -168,10 +1166,50 @@ int main(int argc, char **argv)
     std::cerr << "path to data file not provided\n";
     return 1;
   }
+  double time_limit;
+  if (!parse_time_limit(utils.get_option(argc, argv, "time-limit", "0"), time_limit))
+  {
+    return 1;
+  }
+  Deadline deadline(time_limit);
   std::string test_data_path = argv[1];
-  int n_threads = 8;
-  if (argc > 2 && atoi(argv[2]) > 0 && atoi(argv[2]) <= 8)
-    n_threads = atoi(argv[2]);
+  std::vector<std::string> args = utils.positional_args(argc, argv);
+  std::string engine = utils.get_option(argc, argv, "engine", "dfs");
+  if (engine != "dfs" && engine != "dp" && engine != "threshold" && engine != "mitm")
+  {
+    std::cerr << "unknown engine '" << engine << "' (expected dfs, dp, threshold or mitm)\n";
+    return 1;
+  }
+  // Pobranie liczby wątków z argumentu lub ustawienie domyślnej
+  int num_threads = 8; // Domyślnie
+  if (args.size() >= 2)
+  {
+    try
+    {
+      num_threads = std::stoi(args[1]);
+    }
+    catch (const std::invalid_argument &ia)
+    {
+      std::cerr << "Invalid number of threads: " << args[1] << std::endl;
+      return 1;
+    }
+    catch (const std::out_of_range &oor)
+    {
+      std::cerr << "Number of threads out of range: " << args[1] << std::endl;
+      return 1;
+    }
+  }
+  if (num_threads <= 0)
+  {
+    std::cerr << "Number of threads must be positive." << std::endl;
+    return 1;
+  }
+
+  if (utils.has_option(argc, argv, "batch"))
+  {
+    return run_batch(test_data_path, utils.get_option(argc, argv, "output"), ExactOptions::from_args(argc, argv),
+                     num_threads);
+  }
   int n, s;
   int *stop_vertices;
   int **graph;
@@ -193,34 +1231,134 @@ int main(int argc, char **argv)
     delete[] stop_vertices_check;
     return 0;
   }
-  // Pobranie liczby wątków z argumentu lub ustawienie domyślnej
-  int num_threads = 8; // Domyślnie
-  if (argc >= 3)
+
+  if (engine != "dfs" && s < 2)
   {
-    try
+    std::cerr << engine << " engine needs at least 2 stop vertices, falling back to dfs\n";
+    engine = "dfs";
+  }
+  if (engine == "dp" && n > BOTTLENECK_DP_MAX_VERTICES)
+  {
+    std::cerr << "dp engine supports at most " << BOTTLENECK_DP_MAX_VERTICES << " vertices\n";
+    return 1;
+  }
+  if (engine == "mitm" && !MeetInMiddle::supports(n))
+  {
+    std::cerr << "mitm engine supports at most " << MeetInMiddle::MAX_VERTICES << " vertices\n";
+    return 1;
+  }
+
+  ExactOptions opts = ExactOptions::from_args(argc, argv);
+  opts.symmetry = opts.symmetry && s >= 2 && utils.is_symmetric_arrays(n, graph);
+  if (opts.tt_mb > 0 && !TranspositionTable::supports(n))
+  {
+    std::cerr << "transposition table supports at most " << TranspositionTable::MAX_VERTICES
+              << " vertices, running without it\n";
+    opts.tt_mb = 0;
+  }
+
+  if (engine != "dfs" && deadline.active())
+  {
+    std::cerr << "--time-limit only applies to the dfs engine\n";
+  }
+
+  // Wywołanie solve z podaną liczbą wątków
+  bool proven = true;
+  int *solution;
+  if (engine == "dp")
+  {
+    // Warstwy DP (maski o tej samej liczbie bitów) liczone są równolegle
+    omp_set_num_threads(num_threads);
+    solution = solve_bottleneck_dp(n, graph, stop_vertices_check, false);
+  }
+  else if (engine == "threshold")
+  {
+    // Każde sprawdzenie progu B przeszukuje wierzchołki startowe równolegle
+    omp_set_num_threads(num_threads);
+    solution = new int[n];
+    ThresholdSearch search(n, s, graph, stop_vertices_check, false, opts);
+    if (search.solve(solution) == INT_MAX)
     {
-      num_threads = std::stoi(argv[2]);
+      delete[] solution;
+      solution = nullptr;
     }
-    catch (const std::invalid_argument &ia)
+  }
+  else if (engine == "mitm")
+  {
+    // Warstwy obu połówek i łączenie ich liczone są równolegle
+    omp_set_num_threads(num_threads);
+    solution = new int[n];
+    MeetInMiddle search(n, s, graph, stop_vertices_check, false, opts);
+    if (search.solve(solution) == INT_MAX)
     {
-      std::cerr << "Invalid number of threads: " << argv[2] << std::endl;
-      return 1;
+      delete[] solution;
+      solution = nullptr;
     }
-    catch (const std::out_of_range &oor)
+    if (search.exceeded())
     {
-      std::cerr << "Number of threads out of range: " << argv[2] << std::endl;
+      std::cerr << "mitm engine needs more than --mitm-mb " << opts.mitm_mb
+                << " MB for this instance; raise it or use another engine\n";
+      utils.release_allocated_memory(n, graph, stop_vertices);
+      delete[] stop_vertices_check;
       return 1;
     }
   }
-  if (num_threads <= 0)
+  else
   {
-    std::cerr << "Number of threads must be positive." << std::endl;
-    return 1;
+    int split_depth, port = 0;
+    std::string coordinator_port = utils.get_option(argc, argv, "coordinator");
+    if (!utils.get_int_option(argc, argv, "split-depth", "1", 1, INT_MAX, split_depth) ||
+        (!coordinator_port.empty() && !utils.get_int_option(argc, argv, "coordinator", "", 1, 65535, port)))
+    {
+      utils.release_allocated_memory(n, graph, stop_vertices);
+      delete[] stop_vertices_check;
+      return 1;
+    }
+    std::string worker_address = utils.get_option(argc, argv, "worker");
+    ExactStats stats;
+    if (!worker_address.empty())
+    {
+      // Proces roboczy nie wypisuje wyniku - zna go koordynator
+      int code = run_worker(n, s, graph, stop_vertices_check, opts, stats, worker_address, num_threads);
+      stats.report(opts);
+      utils.release_allocated_memory(n, graph, stop_vertices);
+      delete[] stop_vertices_check;
+      return code;
+    }
+    if (!coordinator_port.empty())
+    {
+      int listener = listen_on(port);
+      if (listener < 0)
+      {
+        std::cerr << "Unable to listen on port " << coordinator_port << ".\n";
+        return 1;
+      }
+      solution = coordinate(n, s, graph, stop_vertices_check, opts, stats, listener, split_depth, deadline, proven);
+      close(listener);
+    }
+    else
+    {
+      Checkpoint checkpoint;
+      uint64_t instance = instance_hash(n, s, graph, stop_vertices_check, "exact_par");
+      if (opts.resume && (!checkpoint.load(opts.checkpoint) || checkpoint.instance != instance ||
+                          (int)checkpoint.path.size() != n))
+      {
+        std::cerr << "Unable to resume from '" << opts.checkpoint << "': missing file or another instance.\n";
+        return 1;
+      }
+      if (opts.resume && !checkpoint.fits(n, s))
+      {
+        std::cerr << "Checkpoint '" << opts.checkpoint << "' is damaged, starting a fresh search.\n";
+        checkpoint = Checkpoint();
+        opts.resume = false;
+      }
+      checkpoint.instance = instance;
+      solution = solve(n, s, graph, stop_vertices_check, opts, stats, checkpoint, deadline, proven, num_threads,
+                       split_depth);
+    }
+    stats.report(opts);
   }
 
-  // Wywołanie solve z podaną liczbą wątków
-  int *solution = solve(n, s, graph, stop_vertices_check, num_threads);
-
   if (solution)
   {
     // Obliczanie max_subpath dla znalezionego rozwiązania
@@ -239,6 +1377,7 @@ int main(int argc, char **argv)
   {
     std::cout << "-1\n"; // Zgodnie z wymaganiami wielu zadań tego typu
   }
+  report_status(deadline, proven ? RunStatus::Optimal : RunStatus::TimeLimit);
 
   // Sprzątanie pamięci
   delete[] stop_vertices;
@@ -1,5 +1,6 @@
 #include <nlohmann/json.hpp>
 #include "../utils.h"
+#include "../anytime.h"
 #include <iostream>
 #include <vector>
 #include <random>
@@ -24,6 +25,8 @@ vec_int stop_vertices;
 vec_bool stop_vertices_check;
 vec_vec_int graph;
 std::ofstream res("genetic.txt");
+Deadline deadline;
+IncumbentLog incumbent_log(deadline);
 
 bool is_valid_solution(const vec_int& solution){
     if(!stop_vertices_check[solution[0]] || !stop_vertices_check[solution.back()])
@@ -63,8 +66,10 @@ void populate(vec_vec_int& population) {
             do {
                 perm = base_permutation;
                 std::shuffle(perm.begin(), perm.end(), rng);
-            } while (!is_valid_solution(perm));
-            local_pop.push_back(perm);
+            } while (!is_valid_solution(perm) && !deadline.expired());
+            // Out of time: the population stays short
+            if (is_valid_solution(perm))
+                local_pop.push_back(perm);
         }
 
         #pragma omp critical
@@ -178,6 +183,9 @@ void evolve_population(vec_vec_int& old_gen) {
     }
 
     populate(new_gen);
+    // Out of time while sampling: keep the previous generation
+    if (new_gen.size() < (size_t)population_size)
+        return;
     mutate(new_gen, stop_vertices_check);
 
     // Sort by fitness and keep best individuals
@@ -207,12 +215,23 @@ bool is_connected(int n, vec_vec_int& g) {
     return std::all_of(visited.begin(), visited.end(), [](bool v) { return v; });
 }
 
+const vec_int& fittest(const vec_vec_int& population) {
+    return *std::min_element(population.begin(), population.end(), [](const vec_int& a, const vec_int& b) {
+        return fitness(a) < fitness(b);
+    });
+}
+
 int main(int argc, char** argv) {
     Utils utils;
     if (argc < 2) {
         std::cerr << "Provide path to input file.\n";
         return -1;
     }
+    double time_limit;
+    if (!parse_time_limit(utils.get_option(argc, argv, "time-limit", "0"), time_limit)) {
+        return 1;
+    }
+    deadline = Deadline(time_limit);
 
     std::string input_path = argv[1];
     utils.read_data_from_json(input_path, n, s, graph, stop_vertices);
@@ -229,16 +248,31 @@ int main(int argc, char** argv) {
     vec_vec_int population;
     populate(population);
 
+    RunStatus status = RunStatus::Finished;
     for (int gen = 0; gen < number_of_generations; ++gen) {
+        if (!population.empty())
+            incumbent_log.improved(fitness(fittest(population)));
+        if (deadline.expired() || population.size() < (size_t)population_size) {
+            status = RunStatus::TimeLimit;
+            break;
+        }
         std::cout << "Generation " << gen + 1 << ":\n";
         evolve_population(population);
         for (const auto& ind : population)
             std::cout << "Fitness: " << fitness(ind) << '\n';
     }
 
+    if (population.empty()) {
+        std::cout << -1 << '\n';
+        report_status(deadline, status);
+        return 0;
+    }
+    const vec_int& best = fittest(population);
+    incumbent_log.improved(fitness(best));
     for (int i = 0; i < n; ++i)
-        std::cout << population[0][i] << ' ';
-    std::cout << "Fitness: " << fitness(population[0]) << '\n';
+        std::cout << best[i] << ' ';
+    std::cout << "Fitness: " << fitness(best) << '\n';
+    report_status(deadline, status);
 
     return 0;
 }
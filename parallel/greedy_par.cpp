@@ -1,5 +1,6 @@
 #include <nlohmann/json.hpp>
 #include "../utils.h" // Ensure the relative path is correct or adjust it to the actual location of utils.h
+#include "../greedy.h"
 #include <string>
 #include <iostream>
 #include <vector>
@@ -7,31 +8,26 @@
 #include <fstream>
 #include <algorithm>
 #include <climits>
+#include <memory>
 #include <omp.h> // Ensure OpenMP is installed and properly configured in your build system
 
 using json = nlohmann::json;
 
-typedef std::vector<int> vec_int;
-typedef std::vector<bool> vec_bool;
-typedef std::vector<std::vector<int>> vec_vec_int;
-
-struct PathWithMaxLength
-{
-    std::vector<int> path;
-    int max_length;
-};
-
-struct subpath
-{
-    vec_int path;
-    int weight;
-};
-
 PathWithMaxLength solve(int n, int s, const vec_vec_int &graph_original, const vec_int &all_stop_vertices)
 {
     PathWithMaxLength best_result = {{}, INT_MAX};
+    // Sorted once for all end vertices, when there are enough of them to pay off
+    std::unique_ptr<GreedyNeighbours> neighbours;
+    if (s >= GREEDY_SHARED_MIN_RUNS)
+    {
+        neighbours.reset(new GreedyNeighbours(graph_original, all_stop_vertices));
+    }
 
-#pragma omp parallel
+    // Without the shared lists ETAP I scans whole rows. With fewer end vertices
+    // than threads and rows long enough for the threaded scans of argmin_simd.h,
+    // the end vertices run one after another and every scan gets all threads.
+    bool split_scans = !neighbours && s < omp_get_max_threads() && n >= masked_argmin_parallel_min();
+#pragma omp parallel if (!split_scans)
     {
         PathWithMaxLength local_best = {{}, INT_MAX};
 
@@ -39,7 +35,7 @@ PathWithMaxLength solve(int n, int s, const vec_vec_int &graph_original, const v
         for (int end_vertex = 0; end_vertex < s; ++end_vertex)
         {
             std::cout << "Processing end_vertex: " << end_vertex << std::endl;
-            vec_vec_int graph = graph_original;
+            GreedyRows graph(graph_original);
             std::vector<subpath> subpaths(n);
             vec_bool to_use(n, true);
             bool skip = false;
@@ -59,36 +55,7 @@ PathWithMaxLength solve(int n, int s, const vec_vec_int &graph_original, const v
 
             // ETAP I
             std::cout << "Starting ETAP I for end_vertex: " << end_vertex << std::endl;
-            for (int j = 0; j < n - s; ++j)
-            {
-                int min_w = INT_MAX;
-                int v_from = -1, v_to = -1;
-
-                for (int v : stop_vertices)
-                {
-                    for (int i = 0; i < n; ++i)
-                    {
-                        int cur_w = graph[v][i] + subpaths[v].weight;
-                        if (to_use[i] && graph[v][i] && cur_w < min_w)
-                        {
-                            min_w = cur_w;
-                            v_from = v;
-                            v_to = i;
-                        }
-                    }
-                }
-
-                if (min_w == INT_MAX)
-                {
-                    skip = true;
-                    break;
-                }
-
-                subpaths[v_from].path.push_back(v_to);
-                subpaths[v_from].weight += graph[v_from][v_to];
-                graph[v_from] = graph[v_to];
-                to_use[v_to] = false;
-            }
+            skip = !greedy_grow_subpaths(n, graph, stop_vertices, subpaths, to_use, n - s, neighbours.get());
             if (skip)
             {
                 std::cout << "Skipping end_vertex: " << end_vertex << " due to incomplete path construction." << std::endl;
@@ -102,59 +69,9 @@ PathWithMaxLength solve(int n, int s, const vec_vec_int &graph_original, const v
             to_use[all_stop_vertices[end_vertex]] = true;
             int max_path_len = 0;
 
-            for (int k = 0; k < s - 2; ++k)
-            {
-                int min_w = INT_MAX;
-                int v_from = -1, v_to = -1;
-
-                for (int i = 0; i < s - 2; ++i)
-                {
-                    for (int j = 0; j < s - 1; ++j)
-                    {
-                        int u = stop_vertices[i], v = stop_vertices[j];
-                        int cur_w = graph[u][v] + subpaths[u].weight;
-                        if (i != j && !to_use[u] && !to_use[v] && graph[u][v] && cur_w < min_w)
-                        {
-                            min_w = cur_w;
-                            v_from = u;
-                            v_to = v;
-                        }
-                    }
-                }
-
-                if (min_w == INT_MAX)
-                {
-                    skip = true;
-                    break;
-                }
-
-                subpaths[v_from].path.insert(
-                    subpaths[v_from].path.end(),
-                    subpaths[v_to].path.begin(),
-                    subpaths[v_to].path.end());
-
-                subpaths[v_from].weight += graph[v_from][v_to];
-                if (subpaths[v_from].weight > max_path_len)
-                {
-                    max_path_len = subpaths[v_from].weight;
-                }
-
-                subpaths[v_from].weight = subpaths[v_to].weight;
-                graph[v_from] = graph[v_to];
-                to_use[v_to] = true;
-            }
-
-            if (skip)
-                continue;
-
             subpath best_sub = {};
-            for (int v : stop_vertices)
-            {
-                if (subpaths[v].path.size() > best_sub.path.size())
-                {
-                    best_sub = subpaths[v];
-                }
-            }
+            if (!greedy_join_subpaths(graph, stop_vertices, subpaths, to_use, best_sub, max_path_len, neighbours.get()))
+                continue;
 
             int last = best_sub.path.back();
             int final_edge = graph[last][all_stop_vertices[end_vertex]];
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Scores a batch of candidate permutations that share a prefix, one lane per
+// candidate, the way max_subpath() does: the segment reaching a stop is closed
+// (and then restarts at 0), and the segment after the last stop counts too.
+// Lanes start from the prefix state and walk their own suffix with gathers
+// from a flat n x n weight matrix; a lane that hits a missing edge scores
+// INT_MAX.
+//
+// The kernel is picked once, at construction, for the widest instruction set
+// the CPU reports: AVX-512 (16 lanes), AVX2 (8 lanes) or the portable scalar
+// loop. The vector kernels are compiled with target attributes, so no -m
+// flags are needed and the binary still runs on older CPUs.
+class BatchEvaluator {
+public:
+    // State after the shared prefix: its last vertex, longest closed segment and
+    // open segment.
+    struct Prefix {
+        int last, closed, open;
+    };
+
+    BatchEvaluator(int n, int **graph, const bool *stops) : n(n), weights(n * n), stop_masks(n) {
+        for (int u = 0; u < n; ++u) {
+            std::copy(graph[u], graph[u] + n, weights.begin() + u * n);
+            stop_masks[u] = stops[u] ? -1 : 0;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx512f")) {
+            kernel = &BatchEvaluator::evaluate_avx512;
+            isa_name = "avx512";
+        } else if (__builtin_cpu_supports("avx2")) {
+            kernel = &BatchEvaluator::evaluate_avx2;
+            isa_name = "avx2";
+        }
+#endif
+    }
+
+    // suffix[j * lanes + i] is the j-th vertex after the prefix in lane i;
+    // lanes must be a multiple of 16. Writes one value per lane.
+    void evaluate(const Prefix &prefix, const int32_t *suffix, int length, int lanes, int32_t *values) const {
+        (this->*kernel)(prefix, suffix, length, lanes, values);
+    }
+
+    const char *isa() const {
+        return isa_name;
+    }
+
+private:
+    using Kernel = void (BatchEvaluator::*)(const Prefix &, const int32_t *, int, int, int32_t *) const;
+
+    int n;
+    std::vector<int32_t> weights;
+    std::vector<int32_t> stop_masks; // -1 for a stop, 0 otherwise
+    Kernel kernel = &BatchEvaluator::evaluate_scalar;
+    const char *isa_name = "scalar";
+
+    void evaluate_scalar(const Prefix &prefix, const int32_t *suffix, int length, int lanes, int32_t *values) const {
+        for (int i = 0; i < lanes; ++i) {
+            int prev = prefix.last, closed = prefix.closed, open = prefix.open;
+            bool ok = true;
+            for (int j = 0; j < length; ++j) {
+                int v = suffix[j * lanes + i];
+                int w = weights[prev * n + v];
+                ok = ok && w != 0;
+                if (stop_masks[prev]) {
+                    closed = std::max(closed, open);
+                    open = 0;
+                }
+                open += w;
+                prev = v;
+            }
+            values[i] = ok ? std::max(closed, open) : INT_MAX;
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    __attribute__((target("avx2"))) void evaluate_avx2(const Prefix &prefix, const int32_t *suffix, int length,
+                                                       int lanes, int32_t *values) const {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i row = _mm256_set1_epi32(n);
+        for (int i = 0; i < lanes; i += 8) {
+            __m256i prev = _mm256_set1_epi32(prefix.last);
+            __m256i closed = _mm256_set1_epi32(prefix.closed);
+            __m256i open = _mm256_set1_epi32(prefix.open);
+            __m256i ok = _mm256_set1_epi32(-1);
+            for (int j = 0; j < length; ++j) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(suffix + j * lanes + i));
+                __m256i w = _mm256_i32gather_epi32(weights.data(), _mm256_add_epi32(_mm256_mullo_epi32(prev, row), v), 4);
+                __m256i stop = _mm256_i32gather_epi32(stop_masks.data(), prev, 4);
+                ok = _mm256_andnot_si256(_mm256_cmpeq_epi32(w, zero), ok);
+                closed = _mm256_blendv_epi8(closed, _mm256_max_epi32(closed, open), stop);
+                open = _mm256_add_epi32(_mm256_andnot_si256(stop, open), w);
+                prev = v;
+            }
+            __m256i value = _mm256_blendv_epi8(_mm256_set1_epi32(INT_MAX), _mm256_max_epi32(closed, open), ok);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i), value);
+        }
+    }
+
+    __attribute__((target("avx512f"))) void evaluate_avx512(const Prefix &prefix, const int32_t *suffix, int length,
+                                                            int lanes, int32_t *values) const {
+        // Masked forms with an all-ones mask: the plain intrinsics start from an
+        // undefined register, which GCC 12 reports under -Wall
+        const __m512i row = _mm512_set1_epi32(n), zero = _mm512_setzero_si512();
+        const __mmask16 all = 0xffff;
+        for (int i = 0; i < lanes; i += 16) {
+            __m512i prev = _mm512_set1_epi32(prefix.last);
+            __m512i closed = _mm512_set1_epi32(prefix.closed);
+            __m512i open = _mm512_set1_epi32(prefix.open);
+            __mmask16 ok = 0xffff;
+            for (int j = 0; j < length; ++j) {
+                __m512i v = _mm512_loadu_si512(suffix + j * lanes + i);
+                __m512i w = _mm512_mask_i32gather_epi32(zero, all, _mm512_add_epi32(_mm512_mullo_epi32(prev, row), v),
+                                                        weights.data(), 4);
+                __m512i stop_lanes = _mm512_mask_i32gather_epi32(zero, all, prev, stop_masks.data(), 4);
+                __mmask16 stop = _mm512_test_epi32_mask(stop_lanes, stop_lanes);
+                ok &= _mm512_test_epi32_mask(w, w);
+                closed = _mm512_mask_max_epi32(closed, stop, closed, open);
+                open = _mm512_add_epi32(_mm512_maskz_mov_epi32(~stop, open), w);
+                prev = v;
+            }
+            __m512i value =
+                _mm512_mask_blend_epi32(ok, _mm512_set1_epi32(INT_MAX), _mm512_maskz_max_epi32(all, closed, open));
+            _mm512_storeu_si512(values + i, value);
+        }
+    }
+#endif
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <climits>
+#include "perm_eval_simd.h"
+
+// Lexicographic walk over the permutations of 0..n-1 for the brute-force
+// solvers, keeping for every position i the state of max_subpath() after
+// perm[0..i]: whether all edges so far exist, the open segment and the longest
+// closed one. next() is std::next_permutation, which rewrites the suffix after
+// its pivot, and only that suffix is rescored. The suffix is shorter than e
+// positions on average, so a step costs O(1) amortised instead of an O(n^2)
+// unranking followed by an O(n) check and evaluation.
+//
+// Scores paths exactly like max_subpath() in brute_seq.cpp / brute_par.cpp: a
+// stop closes the segment that reaches it, and the segment after the last
+// stop counts as well.
+class PermutationWalk {
+public:
+    // Trailing positions that best_completion() scores as one batch: 4! = 24
+    // orders, padded to 32 lanes.
+    static const int TAIL = 4;
+    static const int TAIL_ORDERS = 24;
+    static const int TAIL_LANES = 32;
+
+    PermutationWalk(int n, int **graph, const bool *stops)
+        : n(n), graph(graph), stops(stops), perm(n), edges_ok(n), open(n), closed(n), suffix(TAIL * TAIL_LANES),
+          values(TAIL_LANES) {
+        std::vector<int> order = {0, 1, 2, 3};
+        do {
+            tail_orders.insert(tail_orders.end(), order.begin(), order.end());
+        } while (std::next_permutation(order.begin(), order.end()));
+    }
+
+    // Jumps to the k-th permutation in lexicographic order, k < n!.
+    void seek(uint64_t k, const std::vector<uint64_t> &factorials) {
+        uint32_t used = 0;
+        for (int i = 0; i < n; ++i) {
+            uint64_t rank = k / factorials[n - 1 - i];
+            k %= factorials[n - 1 - i];
+            // The rank-th vertex not used yet
+            int v = -1;
+            for (uint64_t skip = rank + 1; skip > 0;) {
+                ++v;
+                skip -= !(used >> v & 1);
+            }
+            perm[i] = v;
+            used |= uint32_t(1) << v;
+        }
+        rescore(0);
+    }
+
+    // Steps to the next permutation; false after the last one.
+    bool next() {
+        int pivot = n - 2;
+        while (pivot >= 0 && perm[pivot] > perm[pivot + 1]) {
+            --pivot;
+        }
+        if (pivot < 0) {
+            return false;
+        }
+        int swap_with = n - 1;
+        while (perm[swap_with] < perm[pivot]) {
+            --swap_with;
+        }
+        std::swap(perm[pivot], perm[swap_with]);
+        std::reverse(perm.begin() + pivot + 1, perm.end());
+        rescore(pivot);
+        return true;
+    }
+
+    // Jumps past every permutation that starts with perm[0..i], to the successor
+    // of the last of them; false if there is none. In rank terms this moves to
+    // the next multiple of (n - 1 - i)!.
+    bool skip(int i) {
+        std::sort(perm.begin() + i + 1, perm.end(), std::greater<int>());
+        return next();
+    }
+
+    // First position i such that no permutation starting with perm[0..i] scores
+    // below bound: an edge is missing or a segment already reached bound. n if
+    // the whole permutation is a path below bound. Both conditions persist once
+    // they hold, so this is a binary search.
+    int dead_prefix(int bound) const {
+        int lo = 0, hi = n;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (!edges_ok[mid] || std::max(closed[mid], open[mid]) >= bound) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+
+    // perm is the first permutation starting with perm[0..i].
+    bool block_start(int i) const {
+        return std::is_sorted(perm.begin() + i + 1, perm.end());
+    }
+
+    // Scores every order of the last TAIL vertices after perm[0..n - 1 - TAIL]
+    // in one batch. Returns the lowest value, or INT_MAX if no order is a path,
+    // and writes the first permutation reaching it (the one the walk would keep)
+    // to best_path. With symmetric, orders ending below perm[0] are not counted.
+    // Needs n > TAIL; the walk itself does not move.
+    int best_completion(const BatchEvaluator &evaluator, bool symmetric, std::vector<int> &best_path) {
+        int p = n - 1 - TAIL;
+        for (int lane = 0; lane < TAIL_LANES; ++lane) {
+            const int *order = &tail_orders[(lane < TAIL_ORDERS ? lane : 0) * TAIL];
+            for (int j = 0; j < TAIL; ++j) {
+                suffix[j * TAIL_LANES + lane] = perm[p + 1 + order[j]];
+            }
+        }
+        evaluator.evaluate({perm[p], closed[p], open[p]}, suffix.data(), TAIL, TAIL_LANES, values.data());
+        int best = INT_MAX, best_lane = -1;
+        for (int lane = 0; lane < TAIL_ORDERS; ++lane) {
+            if (values[lane] < best && !(symmetric && perm[0] > suffix[(TAIL - 1) * TAIL_LANES + lane])) {
+                best = values[lane];
+                best_lane = lane;
+            }
+        }
+        if (best_lane >= 0) {
+            best_path = perm;
+            for (int j = 0; j < TAIL; ++j) {
+                best_path[p + 1 + j] = suffix[j * TAIL_LANES + best_lane];
+            }
+        }
+        return best;
+    }
+
+    // All n - 1 edges of the permutation exist.
+    bool hamiltonian() const {
+        return edges_ok[n - 1];
+    }
+
+    int value() const {
+        return std::max(closed[n - 1], open[n - 1]);
+    }
+
+    const std::vector<int> &path() const {
+        return perm;
+    }
+
+private:
+    int n;
+    int **graph;
+    const bool *stops;
+    std::vector<int> perm;
+    std::vector<char> edges_ok;
+    std::vector<int> open, closed;
+    std::vector<int> tail_orders; // the TAIL! orders of 0..TAIL-1, lexicographic
+    std::vector<int32_t> suffix, values;
+
+    void rescore(int from) {
+        if (from == 0) {
+            edges_ok[0] = 1;
+            open[0] = closed[0] = 0;
+            from = 1;
+        }
+        for (int i = from; i < n; ++i) {
+            int u = perm[i - 1];
+            int weight = graph[u][perm[i]];
+            edges_ok[i] = edges_ok[i - 1] && weight != 0;
+            closed[i] = stops[u] ? std::max(closed[i - 1], open[i - 1]) : closed[i - 1];
+            open[i] = (stops[u] ? 0 : open[i - 1]) + weight;
+        }
+    }
+};
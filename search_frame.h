@@ -0,0 +1,13 @@
+#pragma once
+
+// One level of the explicit stack of the exact DFS. frames[pos] describes the
+// node whose path holds pos vertices: the state after path[pos - 1] and the
+// position in that depth's row of ordered children. The vertex a frame has
+// descended into is path[pos], so the path, the visited set and the frames
+// together are the whole search state - a partial search can be split, handed
+// to another thread or saved by copying them.
+struct SearchFrame {
+    int cursor; // next entry of the children row to try
+    int count;  // number of entries in the children row (0 for a leaf or a cut node)
+    int cur_l, max_l, used_s;
+};
@@ -20,6 +20,8 @@ Uruchomienie:
 #include <omp.h>
 
 #include "../utils.h"
+#include "../anytime.h"
+#include "../permutation_walk.h"
 
 std::vector<uint64_t> calculate_factorials(unsigned int n) {
     std::vector<uint64_t> facts(n + 1);
@@ -33,61 +35,12 @@ std::vector<uint64_t> calculate_factorials(unsigned int n) {
     return facts;
 }
 
-void get_kth_permutation(unsigned int n, uint64_t k, const std::vector<uint64_t>& factorials, int* result_perm) {
-    std::vector<int> available_elements(n);
-    std::iota(available_elements.begin(), available_elements.end(), 0);
-
-    uint64_t remainder = k;
-
-    for (unsigned int i = 0; i < n; ++i) {
-        unsigned int factorial_idx = n - 1 - i;
-        uint64_t factorial_val = (factorial_idx < factorials.size()) ? factorials[factorial_idx] : 1;
-        if (factorial_val == 0) factorial_val = 1;
-
-        uint64_t index_in_available = remainder / factorial_val;
-        remainder = remainder % factorial_val;
-
-        if (index_in_available >= available_elements.size()) {
-            index_in_available = available_elements.size() - 1;
-        }
-
-        result_perm[i] = available_elements[index_in_available];
-        available_elements.erase(available_elements.begin() + index_in_available);
-    }
-}
-
-bool is_hamiltonian(int n, int **graph, const int *permutation) {
-    for (int j = 0; j < n - 1; j++) {
-        if (graph[permutation[j]][permutation[j + 1]] == 0) {
-            return false;
-        }
-    }
-    return true;
-}
-
-int max_subpath(int n, const int *path, int **graph, const bool *stops) {
-    int current_subpath_sum = 0;
-    int max_found = 0;
-
-    for (int i = 0; i < n - 1; ++i) {
-        if (stops[path[i]]) {
-            if (current_subpath_sum > max_found) {
-                max_found = current_subpath_sum;
-            }
-            current_subpath_sum = 0;
-        }
-        int edge_weight = graph[path[i]][path[i + 1]];
-        current_subpath_sum += edge_weight;
-    }
-
-    if (current_subpath_sum > max_found) {
-        max_found = current_subpath_sum;
-    }
-
-    return max_found;
-}
-
-void find_min_max_path(Utils utils, int n, int **graph, bool *stops) {
+// On a symmetric matrix a permutation and its reverse have the same value, so
+// only the orientation with perm[0] < perm[n - 1] is evaluated. A prefix that
+// misses an edge or already has a segment at the best value skips its whole
+// block of (n - 1 - i)! permutations.
+// Stops at the deadline with the best permutation checked so far.
+void find_min_max_path(Utils utils, int n, int **graph, bool *stops, bool symmetric, const Deadline &deadline) {
     if (n <= 1) {
         std::cout << "Path requires at least 2 vertices.\n";
         return;
@@ -114,18 +67,48 @@ void find_min_max_path(Utils utils, int n, int **graph, bool *stops) {
     std::vector<int> global_best_path;
     int global_min_max = std::numeric_limits<int>::max();
 
-    std::vector<int> current_perm_buffer(n);
-
-    for (uint64_t k = 0; k < permutation_count; ++k) {
-        get_kth_permutation(n, k, factorials, current_perm_buffer.data());
-
-        if (is_hamiltonian(n, graph, current_perm_buffer.data())) {
-            int current_max_subpath = max_subpath(n, current_perm_buffer.data(), graph, stops);
-
-            if (current_max_subpath < global_min_max) {
-                global_min_max = current_max_subpath;
-                global_best_path = current_perm_buffer;
+    PermutationWalk walk(n, graph, stops);
+    // The last TAIL positions of a live prefix are scored as one SIMD batch
+    BatchEvaluator evaluator(n, graph, stops);
+    bool batched = n > PermutationWalk::TAIL;
+    std::vector<int> candidate;
+    IncumbentLog log(deadline);
+    RunStatus status = RunStatus::Optimal;
+
+    walk.seek(0, factorials);
+    for (uint64_t step = 0;; ++step) {
+        if ((step & 0xfff) == 0 && deadline.expired()) {
+            status = RunStatus::TimeLimit;
+            break;
+        }
+        int dead = walk.dead_prefix(global_min_max);
+        if (batched && dead >= n - PermutationWalk::TAIL && walk.block_start(n - 1 - PermutationWalk::TAIL)) {
+            int value = walk.best_completion(evaluator, symmetric, candidate);
+            if (value < global_min_max) {
+                global_min_max = value;
+                global_best_path = candidate;
+                log.improved(global_min_max);
+            }
+            if (!walk.skip(n - 1 - PermutationWalk::TAIL)) {
+                break;
             }
+            continue;
+        }
+        if (dead < n - 1) {
+            if (!walk.skip(dead)) {
+                break;
+            }
+            continue;
+        }
+        const std::vector<int> &perm = walk.path();
+
+        if (dead == n && !(symmetric && perm[0] > perm[n - 1])) {
+            global_min_max = walk.value();
+            global_best_path = perm;
+            log.improved(global_min_max);
+        }
+        if (!walk.next()) {
+            break;
         }
     }
 
@@ -137,6 +120,7 @@ void find_min_max_path(Utils utils, int n, int **graph, bool *stops) {
         }
         std::cout << global_min_max << '\n';
     }
+    report_status(deadline, status);
 }
 
 
@@ -148,14 +132,26 @@ int main(int argc, char *argv[])
         std::cerr << "path to data file not provided\n";
         return 1;
     }
+    double time_limit;
+    if (!parse_time_limit(utils.get_option(argc, argv, "time-limit", "0"), time_limit))
+    {
+        return 1;
+    }
+    Deadline deadline(time_limit);
     std::string test_data_path = argv[1];
     int n, s;
-    bool *stop_vertices;
+    int *stop_vertices;
     int **graph;
     utils.read_data_from_json_to_arrays(test_data_path, n, s, graph, stop_vertices);
+    bool *stops = new bool[n]();
+    for (int i = 0; i < s; ++i) {
+        stops[stop_vertices[i]] = true;
+    }
 
-    find_min_max_path(utils, n, graph, stop_vertices);
+    bool symmetric = !utils.has_option(argc, argv, "no-symmetry") && utils.is_symmetric_arrays(n, graph);
+    find_min_max_path(utils, n, graph, stops, symmetric, deadline);
 
+    delete[] stops;
     utils.release_allocated_memory(n, graph, stop_vertices);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
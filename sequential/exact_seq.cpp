@@ -1,5 +1,14 @@
 #include <nlohmann/json.hpp>
 #include "../utils.h"
+#include "../bottleneck_dp.h"
+#include "../bitset_graph.h"
+#include "../exact_options.h"
+#include "../threshold_search.h"
+#include "../meet_in_middle.h"
+#include "../greedy.h"
+#include "../search_frame.h"
+#include "../checkpoint.h"
+#include "../anytime.h"
 #include <string>
 #include <iostream>
 #include <cstdlib>
@@ -33,79 +42,237 @@ int max_subpath(int *path, int path_size, bool *stop_vertices_check, int **graph
   return max_subpath;
 }
 
-void check_all_possible_paths(int pos, int cur_l, int max_l, int used_s, int *path, bool *visited,
-                              int &min_max_l, int *opt_path, int n, int s, bool *stops, int **graph)
+// State after appending v at position pos (after prev); false if the stop rule
+// or the bound min_max_l cuts the branch.
+bool extend_path(int pos, int prev, int v, int &cur_l, int &max_l, int &used_s,
+                 int min_max_l, int n, int s, bool *stops, int **graph)
 {
-  if (pos == n)
+  cur_l += graph[prev][v];
+  if (stops[v])
   {
-    if (max_l < min_max_l)
+    ++used_s;
+    if (used_s == s && pos != n - 1)
     {
-      min_max_l = max_l;
-      std::copy(path, path + n, opt_path);
+      return false;
     }
-    return;
+    if (max_l < cur_l)
+    {
+      if (cur_l >= min_max_l)
+      {
+        return false;
+      }
+      max_l = cur_l;
+    }
+    cur_l = 0;
   }
-  for (int v = 0; v < n; v++)
+  return true;
+}
+
+// Pushes what is left of an interrupted search onto pending: the untried
+// children of frames base..pos - 1, shallowest first, and then the node at pos
+// itself, so the subtree that would have been searched next ends up on top.
+void spill_frontier(int base, int pos, const int *path, const SearchFrame *frames, const int *children,
+                    int min_max_l, int n, int s, bool *stops, int **graph, std::vector<SubtreeRoot> &pending)
+{
+  for (int d = base; d < pos; ++d)
   {
-    if (graph[path[pos - 1]][v] && !visited[v])
+    const SearchFrame &f = frames[d];
+    for (int i = f.count - 1; i >= f.cursor; --i)
     {
-      path[pos] = v;
-      visited[v] = true;
-      int new_max_l = max_l;
-      int new_cur_l = cur_l + graph[path[pos - 1]][v];
-      int new_used_s = used_s;
-      if (stops[v])
+      int v = children[d * n + i];
+      SubtreeRoot root{std::vector<int>(path, path + d), f.cur_l, f.max_l, f.used_s};
+      if (extend_path(d, path[d - 1], v, root.cur_l, root.max_l, root.used_s, min_max_l, n, s, stops, graph))
       {
-        ++new_used_s;
-        if (new_used_s == s && pos != n - 1)
-        {
-          visited[v] = false;
-          continue;
-        }
-        if (new_max_l < new_cur_l)
+        root.prefix.push_back(v);
+        pending.push_back(std::move(root));
+      }
+    }
+  }
+  const SearchFrame &f = frames[pos];
+  pending.push_back(SubtreeRoot{std::vector<int>(path, path + pos), f.cur_l, f.max_l, f.used_s});
+}
+
+// Iterative DFS over an explicit stack: frames[pos] is the node whose path
+// holds pos vertices (see search_frame.h); the search starts from frames[pos]
+// and returns once that node is exhausted, visiting nodes in the same order as
+// the recursive version did.
+// candidates holds one row of bits.words words per depth: the unvisited
+// neighbours of path[pos - 1] at that depth.
+// children holds one row of n vertices per depth: the same neighbours in the
+// order picked by opts.order. tt is nullptr unless --tt-mb is given.
+// When a checkpoint is due (clock) or the deadline has passed, the search stops,
+// spills its unexplored part onto pending and returns true.
+bool check_all_possible_paths(int pos, int cur_l, int max_l, int used_s, int *path, uint64_t *visited,
+                              int &min_max_l, int *opt_path, int n, int s, bool *stops, int **graph,
+                              const BitsetGraph &bits, uint64_t *candidates, const ChildOrder &order,
+                              int *children, SearchFrame *frames, TranspositionTable *tt,
+                              CheckpointClock *clock, const Deadline &deadline, IncumbentLog &log,
+                              std::vector<SubtreeRoot> &pending, const ExactOptions &opts, ExactStats &stats)
+{
+  int base = pos;
+  frames[pos] = {0, 0, cur_l, max_l, used_s};
+  bool entering = true;
+  while (true)
+  {
+    SearchFrame &f = frames[pos];
+    if (entering)
+    {
+      entering = false;
+      if (pos > base && (stats.nodes & 0xfff) == 0 && ((clock && clock->expired()) || deadline.expired()))
+      {
+        spill_frontier(base, pos, path, frames, children, min_max_l, n, s, stops, graph, pending);
+        return true;
+      }
+      ++stats.nodes;
+      if (pos == n)
+      {
+        if (f.max_l < min_max_l)
         {
-          if (new_cur_l >= min_max_l)
-          {
-            visited[v] = false;
-            continue;
-          }
-          new_max_l = new_cur_l;
+          min_max_l = f.max_l;
+          std::copy(path, path + n, opt_path);
+          log.improved(min_max_l);
         }
-        new_cur_l = 0;
       }
-      check_all_possible_paths(pos + 1, new_cur_l, new_max_l, new_used_s, path, visited, min_max_l, opt_path, n, s, stops, graph);
-      visited[v] = false;
+      // Reversed duplicates: the path has to end in an unvisited stop above path[0]
+      else if (opts.symmetry && stops[path[0]] && !bits.has_unvisited_stop_above(path[0], visited))
+      {
+        ++stats.symmetry_cuts;
+      }
+      else if (opts.connectivity_every > 0 && pos % opts.connectivity_every == 0 &&
+               !bits.reaches_unvisited(path[pos - 1], visited))
+      {
+        ++stats.connectivity_cuts;
+      }
+      // Expanded unless the same visited set and last vertex was already reached
+      // with max_l and cur_l no larger
+      else if (!tt || pos < 2 || pos > n - 2 ||
+               !tt->dominated(visited[0], path[pos - 1], f.used_s, f.max_l, f.cur_l,
+                              opts.symmetry && stops[path[0]] ? path[0] + 1 : 0, stats.tt))
+      {
+        uint64_t *cand = candidates + pos * bits.words;
+        bits.candidates(path[pos - 1], visited, cand);
+        f.count = order.order(path[pos - 1], cand, visited, bits, children + pos * n);
+      }
     }
+    if (f.cursor == f.count)
+    {
+      if (pos == base)
+      {
+        return false;
+      }
+      --pos;
+      BitsetGraph::reset(visited, path[pos]);
+      continue;
+    }
+    int v = children[pos * n + f.cursor++];
+    int new_cur_l = f.cur_l;
+    int new_max_l = f.max_l;
+    int new_used_s = f.used_s;
+    if (!extend_path(pos, path[pos - 1], v, new_cur_l, new_max_l, new_used_s, min_max_l, n, s, stops, graph))
+    {
+      continue;
+    }
+    path[pos] = v;
+    BitsetGraph::set(visited, v);
+    ++pos;
+    frames[pos] = {0, 0, new_cur_l, new_max_l, new_used_s};
+    entering = true;
+  }
+}
+
+void save_checkpoint(Checkpoint &checkpoint, const std::string &file, int min_max_l, const int *opt_path, int n,
+                     const std::vector<SubtreeRoot> &pending)
+{
+  checkpoint.bound = min_max_l;
+  checkpoint.path.assign(opt_path, opt_path + n);
+  checkpoint.frontier = pending;
+  if (!checkpoint.save(file))
+  {
+    std::cerr << "Unable to write checkpoint '" << file << "'.\n";
   }
 }
 
-int *solve(int n, int s, int **graph, bool *stop_vertices_check)
+// checkpoint carries the instance hash, and with --resume the saved search to
+// continue instead of starting from every vertex. proven is false if the search
+// stopped at the deadline with subtrees left.
+int *solve(int n, int s, int **graph, bool *stop_vertices_check, const ExactOptions &opts, ExactStats &stats,
+           Checkpoint &checkpoint, const Deadline &deadline, bool &proven)
 {
-  int *opt_path = new int[n];
+  IncumbentLog log(deadline);
+  int *opt_path = new int[n]();
   int min_max_subpath = INT_MAX;
 
-  int *local_opt_path = new int[n];
-  int local_min_max = INT_MAX;
+  // The greedy path (if any) is the first incumbent, so the search only looks for strictly better paths
+  stats.warm_start = greedy_warm_start(n, s, graph, stop_vertices_check, opts.warm_start_ms, opt_path);
+  if (stats.warm_start != INT_MAX)
+  {
+    min_max_subpath = stats.warm_start;
+    log.improved(min_max_subpath);
+  }
 
-  for (int i = 0; i < n; ++i)
+  // Subtrees still to search; the last one is searched next
+  std::vector<SubtreeRoot> pending;
+  if (opts.resume)
+  {
+    pending = checkpoint.frontier;
+    if (checkpoint.bound < min_max_subpath)
+    {
+      min_max_subpath = checkpoint.bound;
+      std::copy(checkpoint.path.begin(), checkpoint.path.end(), opt_path);
+      log.improved(min_max_subpath);
+    }
+  }
+  else
   {
-    int *path = new int[n];
-    bool *visited = new bool[n]();
-    visited[i] = true;
-    path[0] = i;
-    check_all_possible_paths(1, 0, 0, 1, path, visited, local_min_max, local_opt_path,
-                             n, s, stop_vertices_check, graph);
-    delete[] path;
-    delete[] visited;
+    for (int i = n - 1; i >= 0; --i)
+    {
+      pending.push_back(SubtreeRoot{{i}, 0, 0, 1});
+    }
+  }
 
-    if (local_min_max < min_max_subpath)
+  BitsetGraph bits(n, graph, stop_vertices_check);
+  uint64_t *candidates = new uint64_t[(n + 1) * bits.words];
+  ChildOrder order(n, graph, stop_vertices_check, opts.order);
+  int *children = new int[(n + 1) * n];
+  SearchFrame *frames = new SearchFrame[n + 1];
+  TranspositionTable *tt = opts.tt_mb > 0 ? new TranspositionTable(opts.tt_mb) : nullptr;
+  CheckpointClock *clock = opts.checkpoint.empty() ? nullptr : new CheckpointClock(opts.checkpoint_every);
+  int *path = new int[n];
+  uint64_t *visited = new uint64_t[bits.words];
+  while (!pending.empty() && !deadline.expired())
+  {
+    SubtreeRoot root = std::move(pending.back());
+    pending.pop_back();
+    std::fill(visited, visited + bits.words, 0);
+    for (size_t i = 0; i < root.prefix.size(); ++i)
+    {
+      path[i] = root.prefix[i];
+      BitsetGraph::set(visited, path[i]);
+    }
+    if (check_all_possible_paths(root.prefix.size(), root.cur_l, root.max_l, root.used_s, path, visited,
+                                 min_max_subpath, opt_path, n, s, stop_vertices_check, graph, bits, candidates,
+                                 order, children, frames, tt, clock, deadline, log, pending, opts, stats) &&
+        clock && clock->expired())
     {
-      min_max_subpath = local_min_max;
-      std::copy(local_opt_path, local_opt_path + n, opt_path);
+      save_checkpoint(checkpoint, opts.checkpoint, min_max_subpath, opt_path, n, pending);
+      clock->restart();
     }
   }
+  proven = pending.empty();
+  // The last state is saved too: resuming a finished search just prints the
+  // result, and one stopped by the deadline continues where it stopped
+  if (clock)
+  {
+    save_checkpoint(checkpoint, opts.checkpoint, min_max_subpath, opt_path, n, pending);
+  }
 
-  delete[] local_opt_path;
+  delete[] path;
+  delete[] visited;
+  delete[] candidates;
+  delete[] children;
+  delete[] frames;
+  delete tt;
+  delete clock;
 
   if (min_max_subpath == INT_MAX)
   {
@@ -123,7 +290,19 @@ int main(int argc, char **argv)
     std::cerr << "path to data file not provided\n";
     return 1;
   }
+  double time_limit;
+  if (!parse_time_limit(utils.get_option(argc, argv, "time-limit", "0"), time_limit))
+  {
+    return 1;
+  }
+  Deadline deadline(time_limit);
   std::string test_data_path = argv[1];
+  std::string engine = utils.get_option(argc, argv, "engine", "dfs");
+  if (engine != "dfs" && engine != "dp" && engine != "threshold" && engine != "mitm")
+  {
+    std::cerr << "unknown engine '" << engine << "' (expected dfs, dp, threshold or mitm)\n";
+    return 1;
+  }
   int n, s;
   int *stop_vertices;
   int **graph;
@@ -145,7 +324,88 @@ int main(int argc, char **argv)
     delete[] stop_vertices_check;
     return 0;
   }
-  int *solution = solve(n, s, graph, stop_vertices_check);
+  if (engine != "dfs" && s < 2)
+  {
+    std::cerr << engine << " engine needs at least 2 stop vertices, falling back to dfs\n";
+    engine = "dfs";
+  }
+  if (engine == "dp" && n > BOTTLENECK_DP_MAX_VERTICES)
+  {
+    std::cerr << "dp engine supports at most " << BOTTLENECK_DP_MAX_VERTICES << " vertices\n";
+    return 1;
+  }
+  if (engine == "mitm" && !MeetInMiddle::supports(n))
+  {
+    std::cerr << "mitm engine supports at most " << MeetInMiddle::MAX_VERTICES << " vertices\n";
+    return 1;
+  }
+  ExactOptions opts = ExactOptions::from_args(argc, argv);
+  opts.symmetry = opts.symmetry && s >= 2 && utils.is_symmetric_arrays(n, graph);
+  if (opts.tt_mb > 0 && !TranspositionTable::supports(n))
+  {
+    std::cerr << "transposition table supports at most " << TranspositionTable::MAX_VERTICES
+              << " vertices, running without it\n";
+    opts.tt_mb = 0;
+  }
+  if (engine != "dfs" && deadline.active())
+  {
+    std::cerr << "--time-limit only applies to the dfs engine\n";
+  }
+  ExactStats stats;
+  bool proven = true;
+  int *solution;
+  if (engine == "dp")
+  {
+    solution = solve_bottleneck_dp(n, graph, stop_vertices_check, true);
+  }
+  else if (engine == "threshold")
+  {
+    solution = new int[n];
+    ThresholdSearch search(n, s, graph, stop_vertices_check, true, opts);
+    if (search.solve(solution) == INT_MAX)
+    {
+      delete[] solution;
+      solution = nullptr;
+    }
+  }
+  else if (engine == "mitm")
+  {
+    solution = new int[n];
+    MeetInMiddle search(n, s, graph, stop_vertices_check, true, opts);
+    if (search.solve(solution) == INT_MAX)
+    {
+      delete[] solution;
+      solution = nullptr;
+    }
+    if (search.exceeded())
+    {
+      std::cerr << "mitm engine needs more than --mitm-mb " << opts.mitm_mb
+                << " MB for this instance; raise it or use another engine\n";
+      utils.release_allocated_memory(n, graph, stop_vertices);
+      delete[] stop_vertices_check;
+      return 1;
+    }
+  }
+  else
+  {
+    Checkpoint checkpoint;
+    uint64_t instance = instance_hash(n, s, graph, stop_vertices_check, "exact_seq");
+    if (opts.resume && (!checkpoint.load(opts.checkpoint) || checkpoint.instance != instance ||
+                        (int)checkpoint.path.size() != n))
+    {
+      std::cerr << "Unable to resume from '" << opts.checkpoint << "': missing file or another instance.\n";
+      return 1;
+    }
+    if (opts.resume && !checkpoint.fits(n, s))
+    {
+      std::cerr << "Checkpoint '" << opts.checkpoint << "' is damaged, starting a fresh search.\n";
+      checkpoint = Checkpoint();
+      opts.resume = false;
+    }
+    checkpoint.instance = instance;
+    solution = solve(n, s, graph, stop_vertices_check, opts, stats, checkpoint, deadline, proven);
+    stats.report(opts);
+  }
   if (solution)
   {
     for (int i = 0; i < n; ++i)
@@ -159,6 +419,7 @@ int main(int argc, char **argv)
   {
     std::cout << "No solution found\n";
   }
+  report_status(deadline, proven ? RunStatus::Optimal : RunStatus::TimeLimit);
   delete[] stop_vertices;
   for (int i = 0; i < n; ++i)
   {
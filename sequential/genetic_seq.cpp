@@ -1,5 +1,6 @@
 #include <nlohmann/json.hpp>
 #include "../utils.h"
+#include "../anytime.h"
 #include <iostream>
 #include <vector>
 #include <random>
@@ -23,6 +24,8 @@ vec_int stop_vertices;
 vec_bool stop_vertices_check;
 vec_vec_int graph;
 std::ofstream res("genetic.txt");
+Deadline deadline;
+IncumbentLog incumbent_log(deadline);
 
 bool is_valid_solution(vec_int solution){
     int size = solution.size();
@@ -63,7 +66,11 @@ void populate(vec_vec_int& population){
     for(int i = 0; i < new_solutions; ++i) {
         do {
             std::shuffle(permutation.begin(), permutation.end(), rng);
-        } while(!is_valid_solution(permutation));
+        } while(!is_valid_solution(permutation) && !deadline.expired());
+        // Out of time: the population stays short
+        if(!is_valid_solution(permutation)) {
+            return;
+        }
         population.push_back(permutation);
     }
 }
@@ -183,6 +190,10 @@ void evolve_population(vec_vec_int& old_generation) {
         }
     }
     populate(new_generation);
+    // Out of time while sampling: keep the previous generation
+    if(new_generation.size() < (size_t)population_size) {
+        return;
+    }
     //mutate(new_generation, stop_vertices_check);
     std::sort(new_generation.begin(), new_generation.end(), [](const vec_int& a, const vec_int& b) {
         return fitness(a) < fitness(b);
@@ -212,12 +223,23 @@ bool is_connected(int n, std::vector<std::vector<int>> &graph) {
     return 1;
 }
 
+const vec_int& fittest(const vec_vec_int& population) {
+    return *std::min_element(population.begin(), population.end(), [](const vec_int& a, const vec_int& b) {
+        return fitness(a) < fitness(b);
+    });
+}
+
 int main(int argc, char** argv) {
     Utils utils = Utils();
     if(argc < 2) {
         std::cerr << "needs both paths to data file and to output the solution as argumets\n";
         return -1;
     }
+    double time_limit;
+    if(!parse_time_limit(utils.get_option(argc, argv, "time-limit", "0"), time_limit)) {
+        return 1;
+    }
+    deadline = Deadline(time_limit);
     std::string test_data_path = argv[1];
     utils.read_data_from_json(test_data_path, n, s, graph, stop_vertices);
     if(!is_connected(n, graph)){
@@ -230,12 +252,28 @@ int main(int argc, char** argv) {
         stop_vertices_check[v] = 1;
     }
     populate(population);
+    RunStatus status = RunStatus::Finished;
     for(int i = 0; i < number_of_generations; ++i) {
+        if(!population.empty()) {
+            incumbent_log.improved(fitness(fittest(population)));
+        }
+        if(deadline.expired() || population.size() < (size_t)population_size) {
+            status = RunStatus::TimeLimit;
+            break;
+        }
         evolve_population(population);
     }
+    if(population.empty()) {
+        std::cout << -1 << '\n';
+        report_status(deadline, status);
+        return 0;
+    }
+    const vec_int& best = fittest(population);
+    incumbent_log.improved(fitness(best));
     for(int i = 0; i < n; ++i)
-        std::cout << population[0][i] << ' ';
-    std::cout << fitness(population[0]) << '\n';
+        std::cout << best[i] << ' ';
+    std::cout << fitness(best) << '\n';
+    report_status(deadline, status);
     return 0;
 }
 
@@ -1,4 +1,5 @@
 #include <nlohmann/json.hpp>
+#include "../greedy.h"
 #include <string>
 #include <iostream>
 #include <vector>
@@ -15,11 +16,6 @@ using vec_vec_int = std::vector<std::vector<int>>;
 
 std::string FILENAME = "test.json";
 
-struct subpath {
-    vec_int path;
-    int weight;
-};
-
 int solve(int n, int s, vec_vec_int &graph, vec_int stop_vertices);
 bool is_connected(int n, std::vector<std::vector<int>> &graph);
 void dfs(int n, int v, std::vector<std::vector<int>>& graph, std::vector<bool>& visited);
@@ -34,14 +30,15 @@ int main() {
     return(0);
 }
 
-int solve(int n, int s, vec_vec_int &graph, vec_int all_stop_vertices) {
-    if(!is_connected(n, graph)) {
+int solve(int n, int s, vec_vec_int &graph_original, vec_int all_stop_vertices) {
+    if(!is_connected(n, graph_original)) {
         return -1;
     }
     auto rd = std::random_device {};
     auto rng = std::default_random_engine { rd() };
     std::shuffle(begin(all_stop_vertices), end(all_stop_vertices), rng);
     for(int i_left = 0; i_left < s; ++i_left) {
+        GreedyRows graph(graph_original);
         std::vector<subpath> subpaths(n);
         vec_bool to_use(n, 1);
         bool skip = false;
@@ -55,27 +52,7 @@ int solve(int n, int s, vec_vec_int &graph, vec_int all_stop_vertices) {
         vec_int stop_vertices = all_stop_vertices;
         stop_vertices.erase(stop_vertices.begin() + i_left);
         // ETAP I
-        for(int k = 0; k < n - s; ++k) {
-            int min_w = INT_MAX;
-            int v_from =  -1, v_to = -1;
-            for(int v : stop_vertices) {
-                for(int i = 0; i < n; ++i) {
-                    if(to_use[i] && graph[v][i] && graph[v][i] + subpaths[v].weight < min_w) {
-                        min_w = graph[v][i] + subpaths[v].weight;
-                        v_from = v;
-                        v_to = i;
-                    }
-                }
-            }
-            if(min_w == INT_MAX) {
-                skip = 1;
-                break;
-            }
-            subpaths[v_from].path.push_back(v_to);
-            subpaths[v_from].weight += graph[v_from][v_to];
-            graph[v_from] = graph[v_to];
-            to_use[v_to] = 0;
-        }
+        skip = !greedy_grow_subpaths(n, graph, stop_vertices, subpaths, to_use, n - s);
         if(skip) {
             continue;
         }
@@ -107,7 +84,7 @@ int solve(int n, int s, vec_vec_int &graph, vec_int all_stop_vertices) {
                 max_path_len = subpaths[v_from].weight;
             }
             subpaths[v_from].weight = subpaths[v_to].weight;
-            graph[v_from] = graph[v_to];
+            graph.follow(v_from, v_to);
             to_use[v_to] = 1;
         }
         if(skip) {
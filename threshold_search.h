@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <climits>
+#include "bitset_graph.h"
+#include "bottleneck_dp.h"
+#include "exact_options.h"
+
+// Exact engine that answers "is there a Hamiltonian path whose every segment is
+// <= B?" for a sequence of bottlenecks B picked by search_bottleneck(). Each
+// probe drops the edges heavier than B, so the DFS runs on a much sparser graph,
+// and it stops at the first witness instead of proving optimality itself.
+//
+// Follows the stop rules of check_all_possible_paths: the s-th stop has to be
+// the last vertex, and with start_at_stop only stops may begin a path. Needs
+// s >= 2 so that every segment is closed by a stop.
+class ThresholdSearch {
+public:
+    ThresholdSearch(int n, int s, int **graph, bool *stops, bool start_at_stop, const ExactOptions &opts)
+        : n(n), s(s), graph(graph), stops(stops), start_at_stop(start_at_stop), opts(opts),
+          order(n, graph, stops, opts.order) {}
+
+    bool feasible(int bound, int *path) {
+        BitsetGraph bits(n, graph, stops, bound);
+        std::atomic<bool> found(false);
+#pragma omp parallel
+        {
+            std::vector<int> local_path(n);
+            std::vector<uint64_t> visited(bits.words);
+            std::vector<uint64_t> candidates((n + 1) * bits.words);
+            std::vector<int> children((n + 1) * n);
+#pragma omp for schedule(dynamic)
+            for (int i = 0; i < n; ++i) {
+                if ((start_at_stop && !stops[i]) || found.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+                std::fill(visited.begin(), visited.end(), 0);
+                BitsetGraph::set(visited.data(), i);
+                local_path[0] = i;
+                if (dfs(1, 0, stops[i] ? 1 : 0, bound, local_path.data(), visited.data(), candidates.data(),
+                        children.data(), bits, found)) {
+#pragma omp critical
+                    std::copy(local_path.begin(), local_path.end(), path);
+                }
+            }
+        }
+        return found.load();
+    }
+
+    int solve(int *opt_path) {
+        long long upper_bound = std::min<long long>(bottleneck_upper_bound(n, graph), INT_MAX - 1);
+        return search_bottleneck(
+            n, (int)upper_bound, opt_path,
+            [this](int bound, int *path) { return feasible(bound, path); },
+            [this](const int *path) { return path_value(path); });
+    }
+
+private:
+    int n, s;
+    int **graph;
+    bool *stops;
+    bool start_at_stop;
+    const ExactOptions &opts;
+    ChildOrder order;
+
+    // Returns true only for the thread that completed the witness in `path`.
+    bool dfs(int pos, int cur_l, int used_s, int bound, int *path, uint64_t *visited, uint64_t *candidates,
+             int *children, const BitsetGraph &bits, std::atomic<bool> &found) {
+        if (pos == n) {
+            bool expected = false;
+            return found.compare_exchange_strong(expected, true);
+        }
+        if (found.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (opts.symmetry && stops[path[0]] && !bits.has_unvisited_stop_above(path[0], visited)) {
+            return false;
+        }
+        if (opts.connectivity_every > 0 && pos % opts.connectivity_every == 0 &&
+            !bits.reaches_unvisited(path[pos - 1], visited)) {
+            return false;
+        }
+        uint64_t *cand = candidates + pos * bits.words;
+        bits.candidates(path[pos - 1], visited, cand);
+        int *next = children + pos * n;
+        int count = order.order(path[pos - 1], cand, visited, bits, next);
+        for (int i = 0; i < count; ++i) {
+            int v = next[i];
+            int new_cur_l = cur_l + graph[path[pos - 1]][v];
+            int new_used_s = used_s;
+            // The open segment will be closed by a later stop, so it is bounded too
+            if (new_cur_l > bound) {
+                continue;
+            }
+            if (stops[v]) {
+                ++new_used_s;
+                if (new_used_s > s || (new_used_s == s && pos != n - 1)) {
+                    continue;
+                }
+                new_cur_l = 0;
+            }
+            path[pos] = v;
+            BitsetGraph::set(visited, v);
+            bool done = dfs(pos + 1, new_cur_l, new_used_s, bound, path, visited, candidates, children, bits, found);
+            BitsetGraph::reset(visited, v);
+            if (done) {
+                return true;
+            }
+            if (found.load(std::memory_order_relaxed)) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    int path_value(const int *path) const {
+        int max_l = 0, cur_l = 0;
+        for (int i = 1; i < n; ++i) {
+            cur_l += graph[path[i - 1]][path[i]];
+            if (stops[path[i]]) {
+                max_l = std::max(max_l, cur_l);
+                cur_l = 0;
+            }
+        }
+        return max_l;
+    }
+};
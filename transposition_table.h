@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct TranspositionCounters {
+    long long hits = 0;      // arrivals dominated by a stored visit (subtree cut)
+    long long misses = 0;    // arrivals that had to be searched (and were stored)
+    long long evictions = 0; // stored states overwritten by a different state
+
+    void add(const TranspositionCounters &other) {
+        hits += other.hits;
+        misses += other.misses;
+        evictions += other.evictions;
+    }
+};
+
+// Fixed-size table of DFS states (visited set, last vertex) shared by all search
+// threads without locks. Every entry keeps the (max_l, cur_l) of the last
+// non-dominated visit of its state. A later visit of the same state with both
+// values >= the stored ones cannot lead to a better path: the stored visit has
+// already searched (or is searching) every completion, under a bound that was at
+// most as tight. `start` orders visits by how much of the tree the symmetry rule
+// let them search (0 = unrestricted, a + 1 = only paths ending in a stop above
+// a), so a stored visit only covers arrivals whose start is not smaller. used_s
+// has to match as well: exact_seq counts a start outside the stops as a stop, so
+// it does not always follow from the visited set.
+//
+// The key is (mask << 6 | last vertex), exact for n <= 58. An entry is two
+// 64-bit words, (key ^ data, data), written with independent relaxed stores; a
+// reader that sees a torn entry gets a key mismatch and treats it as a miss.
+// Four entries share a 64-byte bucket; a new state replaces an empty entry, or
+// else the one with the most visited vertices, since deep subtrees are the
+// cheapest to search again.
+class TranspositionTable {
+public:
+    static const int MAX_VERTICES = 58;
+    static const int BUCKET = 4;
+
+    static bool supports(int n) {
+        return n <= MAX_VERTICES;
+    }
+
+    explicit TranspositionTable(size_t megabytes) {
+        size_t buckets = 1;
+        while ((buckets * 2) * BUCKET * 2 * sizeof(uint64_t) <= (megabytes << 20)) {
+            buckets *= 2;
+        }
+        bucket_mask = buckets - 1;
+        words = std::vector<std::atomic<uint64_t>>(buckets * BUCKET * 2);
+    }
+
+    // Returns true if an earlier visit dominates this one; otherwise records it.
+    bool dominated(uint64_t mask, int v, int used_s, int max_l, int cur_l, int start,
+                   TranspositionCounters &counters) {
+        if (max_l > VALUE_MAX || cur_l > VALUE_MAX) {
+            ++counters.misses;
+            return false;
+        }
+        uint64_t key = mask << 6 | v;
+        uint64_t data = uint64_t(max_l) | uint64_t(cur_l) << 24 | uint64_t(start) << 48 | uint64_t(used_s) << 56;
+        std::atomic<uint64_t> *bucket = &words[(hash(key) & bucket_mask) * BUCKET * 2];
+        int victim = 0, victim_depth = -1;
+        bool victim_empty = false;
+        for (int i = 0; i < BUCKET; ++i) {
+            uint64_t stored = bucket[2 * i + 1].load(std::memory_order_relaxed);
+            uint64_t stored_key = bucket[2 * i].load(std::memory_order_relaxed) ^ stored;
+            if (stored_key == key) {
+                if (covers(stored, data)) {
+                    ++counters.hits;
+                    return true;
+                }
+                store(bucket + 2 * i, key, data);
+                ++counters.misses;
+                return false;
+            }
+            bool empty = stored_key == 0 && stored == 0;
+            int depth = __builtin_popcountll(stored_key >> 6);
+            if (!victim_empty && (empty || depth > victim_depth)) {
+                victim = i;
+                victim_depth = depth;
+                victim_empty = empty;
+            }
+        }
+        if (!victim_empty) {
+            ++counters.evictions;
+        }
+        store(bucket + 2 * victim, key, data);
+        ++counters.misses;
+        return false;
+    }
+
+private:
+    static const int VALUE_MAX = (1 << 24) - 1;
+
+    size_t bucket_mask;
+    std::vector<std::atomic<uint64_t>> words;
+
+    static uint64_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+    static bool covers(uint64_t stored, uint64_t data) {
+        const uint64_t field = VALUE_MAX;
+        return (stored & field) <= (data & field) && (stored >> 24 & field) <= (data >> 24 & field) &&
+               (stored >> 48 & 0xff) <= (data >> 48 & 0xff) && stored >> 56 == data >> 56;
+    }
+
+    static void store(std::atomic<uint64_t> *entry, uint64_t key, uint64_t data) {
+        entry[0].store(key ^ data, std::memory_order_relaxed);
+        entry[1].store(data, std::memory_order_relaxed);
+    }
+};
@@ -1,7 +1,10 @@
+#pragma once
+
 #include <iostream>
 #include <fstream>
 #include <filesystem>
 #include <vector>
+#include <string>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -13,6 +16,65 @@ typedef std::vector<std::vector<int>> vec_vec_int;
 
 class Utils {
 public:
+    // Command line: positional arguments come first, followed by options given
+    // as "--name value", "--name=value" or a bare "--flag".
+    static
+    std::vector<std::string> positional_args(int argc, char **argv) {
+        std::vector<std::string> args;
+        for (int i = 1; i < argc && std::string(argv[i]).rfind("--", 0) != 0; ++i) {
+            args.push_back(argv[i]);
+        }
+        return args;
+    }
+
+    static
+    bool has_option(int argc, char **argv, const std::string &name) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--" + name || arg.rfind("--" + name + "=", 0) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static
+    std::string get_option(int argc, char **argv, const std::string &name, const std::string &default_value = "") {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--" + name + "=", 0) == 0) {
+                return arg.substr(name.size() + 3);
+            }
+            if (arg == "--" + name) {
+                if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                    return argv[i + 1];
+                }
+                return default_value;
+            }
+        }
+        return default_value;
+    }
+
+    // Integer option in [min_value, max_value]. The whole value has to parse;
+    // otherwise prints a usage error and returns false.
+    static
+    bool get_int_option(int argc, char **argv, const std::string &name, const std::string &default_value,
+                        int min_value, int max_value, int &value) {
+        std::string text = get_option(argc, argv, name, default_value);
+        try {
+            size_t used = 0;
+            long long parsed = std::stoll(text, &used);
+            if (used == text.size() && parsed >= min_value && parsed <= max_value) {
+                value = (int)parsed;
+                return true;
+            }
+        } catch (const std::exception &) {
+        }
+        std::cerr << "invalid --" << name << " '" << text << "' (expected an integer in [" << min_value << ", "
+                  << max_value << "])\n";
+        return false;
+    }
+
     static
     void read_data_from_json(std::string &filename, int &n, int &s, std::vector<std::vector<int>> &graph, std::vector<int> &stop_vertices) {
         std::ifstream file(filename);
@@ -68,6 +130,34 @@ public:
         }
     }
 
+    // The arrays read_data_from_json_to_arrays() fills, from an already parsed
+    // instance object (a test file, or one line of a --batch input).
+    static
+    void read_instance(const json &data, int &n, int &s, int **&graph, int *&stop_vertices) {
+        n = data["number of vertices"];
+        s = data["number of stop vertices"];
+
+        graph = new int*[n];
+        for (int i = 0; i < n; ++i) {
+            graph[i] = new int[n];
+        }
+
+        // Fill graph
+        auto graph_data = data["graph"].get<std::vector<std::vector<int>>>();
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                graph[i][j] = graph_data[i][j];
+            }
+        }
+
+        stop_vertices = new int[s];
+
+        auto stop_vertices_data = data["stop vertices"].get<std::vector<int>>();
+        for (int i = 0; i < s; ++i) {
+            stop_vertices[i] = stop_vertices_data[i];
+        }
+    }
+
     static
     void read_data_from_json_to_arrays(std::string &filename, int &n, int &s, int **&graph, int *&stop_vertices) {
         std::ifstream file(filename);
@@ -79,29 +169,7 @@ public:
         if (file.is_open()) {
             json data;
             file >> data;
-            n = data["number of vertices"];
-            s = data["number of stop vertices"];
-
-            graph = new int*[n];
-            for (int i = 0; i < n; ++i) {
-                graph[i] = new int[n];
-            }
-
-            // Fill graph
-            auto graph_data = data["graph"].get<std::vector<std::vector<int>>>();
-            for (int i = 0; i < n; ++i) {
-                for (int j = 0; j < n; ++j) {
-                    graph[i][j] = graph_data[i][j];
-                }
-            }
-
-            stop_vertices = new int[s];
-
-            auto stop_vertices_data = data["stop vertices"].get<std::vector<int>>();
-            for (int i = 0; i < s; ++i) {
-                stop_vertices[i] = stop_vertices_data[i];
-            }
-
+            read_instance(data, n, s, graph, stop_vertices);
             file.close();
         } else {
             std::cerr << "Unable to open file '" << filename << "'." << '\n';
@@ -124,6 +192,19 @@ public:
         }
     }
 
+    // An undirected instance: every path and its reverse have the same value.
+    static
+    bool is_symmetric_arrays(int n, int **graph) {
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < i; ++j) {
+                if (graph[i][j] != graph[j][i]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
     static
     bool is_connected_arrays(int n, int **graph) {
         bool *visited = new bool[n]();